@@ -0,0 +1,25 @@
+#define GEN_IMPLEMENTATION
+
+#include "gen.h"
+
+// 2000 sonar depths per scale, a noisy walk that mostly goes deeper like the puzzle input
+#define DEPTHS_PER_SCALE 2000
+
+static bool generate(gen_rng_t *rng, u64 scale, FILE *out)
+{
+    i64 depth = gen_range(rng, 100, 200);
+
+    for (u64 i = 0; i < DEPTHS_PER_SCALE * scale; ++i) {
+        depth += gen_range(rng, -8, 12);
+
+        if (depth < 0)
+            depth = -depth;
+
+        if (fprintf(out, "%lld\n", (long long)depth) < 0)
+            return false;
+    }
+
+    return true;
+}
+
+GEN_MAIN(generate)
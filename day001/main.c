@@ -1,70 +1,207 @@
 #include <stdio.h>
 
+#ifndef AOC_RUNNER
 #define ARENA_IMPLEMENTATION
-#include "arena.h"
+#define PERF_IMPLEMENTATION
+#define TIMER_IMPLEMENTATION
 #define FILE_IMPLEMENTATION
-#include "file.h"
 #define UTILS_IMPLEMENTATION
+#define STR_IMPLEMENTATION
+#define THREAD_POOL_IMPLEMENTATION
+#define PARALLEL_SPLIT_IMPLEMENTATION
+#define CACHE_IMPLEMENTATION
+#define LOGGER_IMPLEMENTATION
+#define DAY_IMPLEMENTATION
+#endif
+
+#include "arena.h"
+#include "perf.h"
+#include "timer.h"
+#include "file.h"
 #include "utils.h"
+#include "str.h"
+#include "thread_pool.h"
+#include "parallel_split.h"
+#include "cache.h"
+#include "logger.h"
+#include "day.h"
 
-#define ARENA_SIZE 1024
+#define FILE_NAME "day001/input.txt"
+#define WINDOW_SIZE 3
 
 typedef struct {
-    arena_t *arena;
-    string_chunks_t *chunks;
+    i64 *items;
+    usize size;
+    usize capacity;
+} depths_t;
+
+typedef struct {
+    depths_t *depths; // NULL when the input was streamed, the answers are counted instead
+    i64 depth_increases;
+    i64 window_increases;
 } context_t;
 
-void solve_part1(const context_t *ctx);
-void solve_part2(const context_t *ctx);
+static void *parse_input(arena_t *arena, str_t source);
+static void *parse_input_stream(arena_t *arena, line_reader_t *reader);
+static bool parse_depths(void *context, arena_t *arena, arena_t *scratch, str_t chunk,
+                         parallel_segment_t *segment);
+static bool save_depths(arena_t *arena, void *data, cache_writer_t *writer);
+static void *load_depths(arena_t *arena, const cache_view_t *view);
+static i64 solve_part1(void *data);
+static i64 solve_part2(void *data);
+
+const day_t day001 = {
+    .name = "day001",
+    .input = FILE_NAME,
+    .parse = parse_input,
+    .parse_stream = parse_input_stream,
+    .stream_delim = '\n',
+    .stream_min_size = DAY_STREAM_MIN_SIZE,
+    .part1 = solve_part1,
+    .part2 = solve_part2,
+    .cache_version = 1,
+    .cache_save = save_depths,
+    .cache_load = load_depths,
+};
+
+DAY_MAIN(day001)
+
+static void *parse_input(arena_t *arena, str_t source)
+{
+    TIMER_SCOPE("parse");
+
+    context_t *ctx = arena_alloc(arena, sizeof(*ctx));
+    depths_t *depths = arena_alloc(arena, sizeof(*depths));
+    if (!ctx || !depths)
+        return NULL;
+
+    *ctx = (context_t){ 0 };
+    depths->items = parallel_split(thread_pool_default(), arena, source, '\n',
+                                   sizeof(*depths->items), parse_depths, NULL, &depths->size);
+    if (!depths->items)
+        return NULL;
 
-int main(void)
+    depths->capacity = depths->size;
+    ctx->depths = depths;
+
+    return ctx;
+}
+
+// inputs too large to hold are folded as they are read, only the last window is kept
+static void *parse_input_stream(arena_t *arena, line_reader_t *reader)
 {
-    arena_t arena = { 0 };
-    if (!arena_create(&arena, ARENA_SIZE)) {
-        fprintf(stderr, "Failed to create arena\n");
-        return 1;
+    TIMER_SCOPE("parse");
+
+    context_t *ctx = arena_alloc(arena, sizeof(*ctx));
+    if (!ctx)
+        return NULL;
+
+    *ctx = (context_t){ 0 };
+
+    i64 window[WINDOW_SIZE] = { 0 };
+    usize count = 0;
+    char *record = NULL;
+    usize record_len = 0;
+
+    while (line_reader_next(reader, &record, &record_len)) {
+        i64 depth = 0;
+        parse_err_t error = PARSE_OK;
+
+        if (parse_i64(record, record_len, 10, &depth, &error) != record_len || error != PARSE_OK)
+            return NULL;
+
+        if (count >= 1 && depth > window[(count - 1) % WINDOW_SIZE])
+            ctx->depth_increases += 1;
+
+        if (count >= WINDOW_SIZE && depth > window[count % WINDOW_SIZE])
+            ctx->window_increases += 1;
+
+        window[count % WINDOW_SIZE] = depth;
+        count += 1;
     }
 
-    char *source = get_input(&arena, "day001/input.txt");
+    return ctx;
+}
+
+static bool parse_depths(void *context, arena_t *arena, arena_t *scratch, str_t chunk,
+                         parallel_segment_t *segment)
+{
+    (void)context, (void)scratch;
+
+    segment->items = parse_i64_list(arena, chunk.data, chunk.len, '\n', &segment->count);
+    return segment->items != NULL;
+}
+
+static bool save_depths(arena_t *arena, void *data, cache_writer_t *writer)
+{
+    (void)arena;
+
+    const context_t *ctx = data;
+
+    cache_writer_add(writer, ctx->depths->items, ctx->depths->size * sizeof(*ctx->depths->items));
+    return true;
+}
+
+static void *load_depths(arena_t *arena, const cache_view_t *view)
+{
+    u64 size = 0;
+    i64 *items = cache_section(view, 0, &size);
 
-    context_t ctx = { .chunks = split_str(&arena, source, "\n"), .arena = &arena };
+    context_t *ctx = arena_alloc(arena, sizeof(*ctx));
+    depths_t *depths = arena_alloc(arena, sizeof(*depths));
+    if (!items || !ctx || !depths)
+        return NULL;
 
-    solve_part1(&ctx);
-    solve_part2(&ctx);
+    *ctx = (context_t){ 0 };
 
-    arena_destroy(&arena);
+    depths->items = items;
+    depths->size = size / sizeof(*items);
+    depths->capacity = depths->size;
+    ctx->depths = depths;
 
-    return 0;
+    return ctx;
 }
 
-void solve_part2(const context_t *ctx)
+static i64 solve_part2(void *data)
 {
+    TIMER_SCOPE("part2");
+
+    const context_t *ctx = data;
     usize measurements = 0;
-    usize window_size = 3;
+    usize window_size = WINDOW_SIZE;
+
+    if (!ctx->depths)
+        return ctx->window_increases;
 
-    for (usize i = 0; i < ctx->chunks->size - window_size; ++i) {
-        i64 fourth_elem = parse_int(ctx->chunks->items[i + window_size], 10);
-        i64 first_in_window = parse_int(ctx->chunks->items[i], 10);
+    for (usize i = 0; i < ctx->depths->size - window_size; ++i) {
+        i64 fourth_elem = ctx->depths->items[i + window_size];
+        i64 first_in_window = ctx->depths->items[i];
 
         if (fourth_elem > first_in_window)
             measurements += 1;
     }
 
-    printf("P2/Measurements: %zu\n", measurements);
+    return (i64)measurements;
 }
 
-void solve_part1(const context_t *ctx)
+static i64 solve_part1(void *data)
 {
+    TIMER_SCOPE("part1");
+
+    const context_t *ctx = data;
     usize measurements = 0;
     i64 prev_measurement = -1;
 
-    for (usize i = 0; i < ctx->chunks->size; ++i) {
-        i64 current_measurement = parse_int(ctx->chunks->items[i], 10);
+    if (!ctx->depths)
+        return ctx->depth_increases;
+
+    for (usize i = 0; i < ctx->depths->size; ++i) {
+        i64 current_measurement = ctx->depths->items[i];
         if (prev_measurement != -1 && current_measurement > prev_measurement)
             measurements += 1;
 
         prev_measurement = current_measurement;
     }
 
-    printf("P1/Measurements: %zu\n", measurements);
+    return (i64)measurements;
 }
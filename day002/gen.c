@@ -0,0 +1,37 @@
+#define GEN_IMPLEMENTATION
+
+#include "gen.h"
+
+// 1000 commands per scale. day002 keeps its positions in i32, so aim is held within
+// [0, AIM_MAX] to keep the part 2 depth in range up to roughly 10^4 times the input
+#define COMMANDS_PER_SCALE 1000
+#define AIM_MAX 100
+
+static bool generate(gen_rng_t *rng, u64 scale, FILE *out)
+{
+    i64 aim = 0;
+
+    for (u64 i = 0; i < COMMANDS_PER_SCALE * scale; ++i) {
+        i64 units = gen_range(rng, 1, 9);
+        const char *command = "forward";
+
+        if (gen_below(rng, 5) >= 2) {
+            bool down = gen_below(rng, 2) == 0;
+
+            if (aim - units < 0)
+                down = true;
+            else if (aim + units > AIM_MAX)
+                down = false;
+
+            aim += down ? units : -units;
+            command = down ? "down" : "up";
+        }
+
+        if (fprintf(out, "%s %lld\n", command, (long long)units) < 0)
+            return false;
+    }
+
+    return true;
+}
+
+GEN_MAIN(generate)
@@ -1,14 +1,33 @@
 #include <stdio.h>
-#include <assert.h>
+#include <string.h>
 
+#ifndef AOC_RUNNER
 #define ARENA_IMPLEMENTATION
-#include "arena.h"
+#define PERF_IMPLEMENTATION
+#define TIMER_IMPLEMENTATION
 #define FILE_IMPLEMENTATION
-#include "file.h"
 #define UTILS_IMPLEMENTATION
+#define STR_IMPLEMENTATION
+#define THREAD_POOL_IMPLEMENTATION
+#define PARALLEL_SPLIT_IMPLEMENTATION
+#define CACHE_IMPLEMENTATION
+#define LOGGER_IMPLEMENTATION
+#define DAY_IMPLEMENTATION
+#endif
+
+#include "arena.h"
+#include "perf.h"
+#include "timer.h"
+#include "file.h"
 #include "utils.h"
+#include "str.h"
+#include "thread_pool.h"
+#include "parallel_split.h"
+#include "cache.h"
+#include "logger.h"
+#include "day.h"
 
-#define ARENA_SIZE 1024
+#define FILE_NAME "day002/input.txt"
 
 typedef enum {
     DIR_FORWARD,
@@ -29,48 +48,48 @@ typedef struct {
 } da_instruction_t;
 
 typedef struct {
-    arena_t *arena;
-    const char *source;
-    da_instruction_t *instructions;
+    da_instruction_t *instructions; // NULL when streamed, the answers are kept instead
+    i64 part1;
+    i64 part2;
 } context_t;
 
-void solve_part1(const context_t *ctx);
-void solve_part2(const context_t *ctx);
-da_instruction_t *parse_input(arena_t *arena, const char *source);
-
-int main(void)
-{
-    arena_t arena = { 0 };
-    if (!arena_create(&arena, ARENA_SIZE)) {
-        fprintf(stderr, "Failed to create arena\n");
-        return 1;
-    }
-
-    char *source = get_input(&arena, "day002/input.txt");
+static i64 solve_part1(void *data);
+static i64 solve_part2(void *data);
+static void *parse_input(arena_t *arena, str_t source);
+static void *parse_input_stream(arena_t *arena, line_reader_t *reader);
+static bool parse_instruction(str_t line, instruction_t *instr);
+static bool parse_instructions(void *context, arena_t *arena, arena_t *scratch, str_t chunk,
+                               parallel_segment_t *segment);
+static bool save_instructions(arena_t *arena, void *data, cache_writer_t *writer);
+static void *load_instructions(arena_t *arena, const cache_view_t *view);
 
-    if (!source) {
-        fprintf(stderr, "Failed to read input file\n");
-        arena_destroy(&arena);
-        return 1;
-    }
-
-    context_t ctx = { .instructions = parse_input(&arena, source),
-                      .arena = &arena,
-                      .source = source };
-
-    solve_part1(&ctx);
-    solve_part2(&ctx);
+const day_t day002 = {
+    .name = "day002",
+    .input = FILE_NAME,
+    .parse = parse_input,
+    .parse_stream = parse_input_stream,
+    .stream_delim = '\n',
+    .stream_min_size = DAY_STREAM_MIN_SIZE,
+    .part1 = solve_part1,
+    .part2 = solve_part2,
+    .cache_version = 1,
+    .cache_save = save_instructions,
+    .cache_load = load_instructions,
+};
 
-    arena_destroy(&arena);
-
-    return 0;
-}
+DAY_MAIN(day002)
 
-void solve_part1(const context_t *ctx)
+static i64 solve_part1(void *data)
 {
+    TIMER_SCOPE("part1");
+
+    const context_t *ctx = data;
     i32 current_depth = 0;
     i32 current_horz_pos = 0;
 
+    if (!ctx->instructions)
+        return ctx->part1;
+
     for (usize i = 0; i < ctx->instructions->size; ++i) {
         instruction_t instr = ctx->instructions->items[i];
 
@@ -90,15 +109,21 @@ void solve_part1(const context_t *ctx)
         }
     }
 
-    printf("P1/Result: %d\n", current_horz_pos * current_depth);
+    return (i64)current_horz_pos * current_depth;
 }
 
-void solve_part2(const context_t *ctx)
+static i64 solve_part2(void *data)
 {
+    TIMER_SCOPE("part2");
+
+    const context_t *ctx = data;
     i32 current_depth = 0;
     i32 current_horz_pos = 0;
     i32 aim = 0;
 
+    if (!ctx->instructions)
+        return ctx->part2;
+
     for (usize i = 0; i < ctx->instructions->size; ++i) {
         instruction_t instr = ctx->instructions->items[i];
 
@@ -119,36 +144,164 @@ void solve_part2(const context_t *ctx)
         }
     }
 
-    printf("P2/Result: %d\n", current_horz_pos * current_depth);
+    return (i64)current_horz_pos * current_depth;
 }
 
-da_instruction_t *parse_input(arena_t *arena, const char *source)
+static void *parse_input(arena_t *arena, str_t source)
 {
-    string_chunks_t *chunks = split_str(arena, source, "\n");
+    TIMER_SCOPE("parse");
+
+    context_t *ctx = arena_alloc(arena, sizeof(*ctx));
     da_instruction_t *da = arena_alloc(arena, sizeof(*da));
-    arena_da_init(arena, da, ARENA_DA_CAPACITY);
+    if (!ctx || !da)
+        return NULL;
 
-    for (usize i = 0; i < chunks->size; ++i) {
-        const char *chunk = chunks->items[i];
-        string_chunks_t *space_chunks = split_str(arena, chunk, " ");
-        assert(space_chunks->size == 2);
+    *ctx = (context_t){ 0 };
 
-        direction_t dir = DIR_UNKNOWN;
+    // the course is replayed in order, parallel_split keeps the lines in input order
+    da->items = parallel_split(thread_pool_default(), arena, source, '\n', sizeof(*da->items),
+                               parse_instructions, NULL, &da->size);
+    if (!da->items)
+        return NULL;
 
-        if (strcmp(space_chunks->items[0], "forward") == 0) {
-            dir = DIR_FORWARD;
-        } else if (strcmp(space_chunks->items[0], "up") == 0) {
-            dir = DIR_UP;
-        } else if (strcmp(space_chunks->items[0], "down") == 0) {
-            dir = DIR_DOWN;
-        }
+    da->capacity = da->size;
+    ctx->instructions = da;
+
+    return ctx;
+}
+
+// "forward 5", anything else fails the parse so a bad line never reaches the solvers
+static bool parse_instruction(str_t line, instruction_t *instr)
+{
+    const char *space = memchr(line.data, ' ', line.len);
+    if (!space)
+        return false;
+
+    str_t word = { .data = line.data, .len = (usize)(space - line.data) };
+    str_t amount = { .data = space + 1, .len = line.len - word.len - 1 };
+
+    if (str_eq(word, STR("forward"))) {
+        instr->direction = DIR_FORWARD;
+    } else if (str_eq(word, STR("up"))) {
+        instr->direction = DIR_UP;
+    } else if (str_eq(word, STR("down"))) {
+        instr->direction = DIR_DOWN;
+    } else {
+        return false;
+    }
+
+    i64 position = 0;
+    parse_err_t error = PARSE_OK;
+
+    if (parse_i64(amount.data, amount.len, 10, &position, &error) != amount.len ||
+        error != PARSE_OK || position < INT32_MIN || position > INT32_MAX)
+        return false;
+
+    instr->position = (i32)position;
+    return true;
+}
+
+// this runs on a pool worker, a bad line fails the chunk instead of exiting from here
+static bool parse_instructions(void *context, arena_t *arena, arena_t *scratch, str_t chunk,
+                               parallel_segment_t *segment)
+{
+    (void)context, (void)scratch;
+
+    split_iter_t lines = split_iter_init(chunk, STR("\n"));
+    str_t line = { 0 };
+    da_instruction_t da = { 0 };
+    arena_da_init(arena, &da, ARENA_DA_CAPACITY);
+
+    while (split_iter_next(&lines, &line)) {
+        instruction_t instr = { 0 };
+
+        if (!parse_instruction(line, &instr))
+            return false;
 
-        instruction_t instr =
-            (instruction_t){ .direction = dir,
-                             .position = (i32)parse_int(space_chunks->items[1], 10) };
+        arena_da_append(arena, &da, instr);
+    }
+
+    segment->items = da.items;
+    segment->count = da.size;
+
+    return true;
+}
+
+// inputs too large to hold are replayed as they are read, both courses at once
+static void *parse_input_stream(arena_t *arena, line_reader_t *reader)
+{
+    TIMER_SCOPE("parse");
+
+    context_t *ctx = arena_alloc(arena, sizeof(*ctx));
+    if (!ctx)
+        return NULL;
+
+    *ctx = (context_t){ 0 };
+
+    i64 horz_pos = 0;
+    i64 depth = 0;
+    i64 aim = 0;
+    i64 aimed_depth = 0;
+    char *record = NULL;
+    usize record_len = 0;
 
-        arena_da_append(arena, da, instr);
+    while (line_reader_next(reader, &record, &record_len)) {
+        instruction_t instr = { 0 };
+
+        if (!parse_instruction((str_t){ .data = record, .len = record_len }, &instr))
+            return NULL;
+
+        switch (instr.direction) {
+        case DIR_FORWARD:
+            horz_pos += instr.position;
+            aimed_depth += aim * instr.position;
+            break;
+        case DIR_DOWN:
+            depth += instr.position;
+            aim += instr.position;
+            break;
+        case DIR_UP:
+            depth -= instr.position;
+            aim -= instr.position;
+            break;
+        default:
+            return NULL;
+        }
     }
 
-    return da;
+    ctx->part1 = horz_pos * depth;
+    ctx->part2 = horz_pos * aimed_depth;
+
+    return ctx;
+}
+
+static bool save_instructions(arena_t *arena, void *data, cache_writer_t *writer)
+{
+    (void)arena;
+
+    const context_t *ctx = data;
+    const da_instruction_t *da = ctx->instructions;
+
+    cache_writer_add(writer, da->items, da->size * sizeof(*da->items));
+    return true;
+}
+
+static void *load_instructions(arena_t *arena, const cache_view_t *view)
+{
+    u64 size = 0;
+    instruction_t *items = cache_section(view, 0, &size);
+
+    context_t *ctx = arena_alloc(arena, sizeof(*ctx));
+    da_instruction_t *da = arena_alloc(arena, sizeof(*da));
+    if (!items || !ctx || !da)
+        return NULL;
+
+    *ctx = (context_t){ 0 };
+
+    da->items = items;
+    da->size = size / sizeof(*items);
+    da->capacity = da->size;
+    ctx->instructions = da;
+
+    return ctx;
 }
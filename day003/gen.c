@@ -0,0 +1,35 @@
+#define GEN_IMPLEMENTATION
+
+#include "gen.h"
+
+// 1000 diagnostic numbers per scale, one bit wider for every doubling so the rating search
+// keeps about the same number of candidates per bit. day003 stores them in i32
+#define NUMBERS_PER_SCALE 1000
+#define BASE_BITS 12
+#define MAX_BITS 31
+
+static bool generate(gen_rng_t *rng, u64 scale, FILE *out)
+{
+    u32 bits = BASE_BITS;
+
+    for (u64 s = scale; s > 1 && bits < MAX_BITS; s >>= 1)
+        ++bits;
+
+    char line[MAX_BITS + 2];
+    line[bits] = '\n';
+    line[bits + 1] = '\0';
+
+    for (u64 i = 0; i < NUMBERS_PER_SCALE * scale; ++i) {
+        u64 value = gen_next(rng);
+
+        for (u32 bit = 0; bit < bits; ++bit)
+            line[bit] = (char)('0' + ((value >> bit) & 1));
+
+        if (fputs(line, out) < 0)
+            return false;
+    }
+
+    return true;
+}
+
+GEN_MAIN(generate)
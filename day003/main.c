@@ -3,14 +3,29 @@
 #include <assert.h>
 #include <string.h>
 
+#ifndef AOC_RUNNER
 #define ARENA_IMPLEMENTATION
-#include "arena.h"
+#define PERF_IMPLEMENTATION
+#define TIMER_IMPLEMENTATION
 #define FILE_IMPLEMENTATION
-#include "file.h"
 #define UTILS_IMPLEMENTATION
+#define STR_IMPLEMENTATION
+#define CACHE_IMPLEMENTATION
+#define LOGGER_IMPLEMENTATION
+#define DAY_IMPLEMENTATION
+#endif
+
+#include "arena.h"
+#include "perf.h"
+#include "timer.h"
+#include "file.h"
 #include "utils.h"
+#include "str.h"
+#include "cache.h"
+#include "logger.h"
+#include "day.h"
 
-#define ARENA_SIZE 1024
+#define FILE_NAME "day003/input.txt"
 
 typedef enum {
     RATING_OXYGEN,
@@ -30,41 +45,34 @@ typedef struct {
 
 typedef struct {
     arena_t *arena;
-    const char *source;
     binary_data_t binary_data;
 } context_t;
 
-static binary_data_t parse_input(arena_t *arena, const char *source);
-static void solve_part1(const context_t *ctx);
-static void solve_part2(const context_t *ctx);
+static void *parse_input(arena_t *arena, str_t source);
+static i64 solve_part1(void *data);
+static i64 solve_part2(void *data);
 static i32 calculate_rating(const context_t *ctx, rating_type_t type);
-
-int main(void)
+static bool save_binary_data(arena_t *arena, void *data, cache_writer_t *writer);
+static void *load_binary_data(arena_t *arena, const cache_view_t *view);
+
+const day_t day003 = {
+    .name = "day003",
+    .input = FILE_NAME,
+    .parse = parse_input,
+    .part1 = solve_part1,
+    .part2 = solve_part2,
+    .cache_version = 1,
+    .cache_save = save_binary_data,
+    .cache_load = load_binary_data,
+};
+
+DAY_MAIN(day003)
+
+static i64 solve_part1(void *data)
 {
-    arena_t arena = { 0 };
-    if (!arena_create(&arena, ARENA_SIZE)) {
-        fprintf(stderr, "Failed to create arena\n");
-        return 1;
-    }
-
-    const char *source = get_input(&arena, "day003/input.txt");
-
-    context_t ctx = {
-        .arena = &arena,
-        .source = source,
-        .binary_data = parse_input(&arena, source),
-    };
+    TIMER_SCOPE("part1");
 
-    solve_part1(&ctx);
-    solve_part2(&ctx);
-
-    arena_destroy(&arena);
-
-    return 0;
-}
-
-static void solve_part1(const context_t *ctx)
-{
+    const context_t *ctx = data;
     usize bit_count = ctx->binary_data.bit_count;
     i32 gamma_rate = 0;
     i32 epsilon_rate = 0;
@@ -86,39 +94,91 @@ static void solve_part1(const context_t *ctx)
         epsilon_rate |= (ones < zeros) << bit_idx;
     }
 
-    printf("P1/Power Consumption: %d\n", gamma_rate * epsilon_rate);
+    return (i64)gamma_rate * epsilon_rate;
 }
 
-static void solve_part2(const context_t *ctx)
+static i64 solve_part2(void *data)
 {
+    TIMER_SCOPE("part2");
+
+    const context_t *ctx = data;
     i32 oxygen_generator_rating = calculate_rating(ctx, RATING_OXYGEN);
     i32 co2_scrubber_rating = calculate_rating(ctx, RATING_CO2);
 
-    printf("P2/Life Support Rating: %d\n", oxygen_generator_rating * co2_scrubber_rating);
+    return (i64)oxygen_generator_rating * co2_scrubber_rating;
 }
 
-static binary_data_t parse_input(arena_t *arena, const char *source)
+static void *parse_input(arena_t *arena, str_t source)
 {
-    assert(source);
-    assert(strlen(source) > 0);
+    TIMER_SCOPE("parse");
+
+    assert(source.data);
+    assert(source.len > 0);
+
+    context_t *ctx = arena_alloc(arena, sizeof(*ctx));
+    if (!ctx)
+        return NULL;
 
-    string_chunks_t *lines = split_str(arena, source, "\n");
     binary_chunks_t *chunks = arena_alloc(arena, sizeof(*chunks));
     arena_da_init(arena, chunks, ARENA_DA_CAPACITY);
 
-    for (usize i = 0; i < lines->size; ++i) {
-        const char *binary_str = lines->items[i];
-        const usize str_len = strlen(binary_str);
-        i32 binary_val = 0;
+    split_iter_t lines = split_iter_init(source, STR("\n"));
+    str_t binary_str = { 0 };
+    usize bit_count = 0;
 
-        for (usize j = 0; j < str_len; ++j) {
-            binary_val = (binary_val << 1) + (binary_str[j] - '0');
-        }
+    while (split_iter_next(&lines, &binary_str)) {
+        i64 binary_val = 0;
+        if (!str_parse_int(binary_str, 2, &binary_val))
+            return NULL;
+
+        bit_count = binary_str.len - 1;
 
-        arena_da_append(arena, chunks, binary_val);
+        arena_da_append(arena, chunks, (i32)binary_val);
     }
 
-    return (binary_data_t){ .chunks = chunks, .bit_count = strlen(lines->items[0]) - 1 };
+    // part 2 narrows candidates down in scratch copies taken from the same arena
+    ctx->arena = arena;
+    ctx->binary_data = (binary_data_t){ .chunks = chunks, .bit_count = bit_count };
+
+    return ctx;
+}
+
+// the bit count goes first as its own section, the values follow
+static bool save_binary_data(arena_t *arena, void *data, cache_writer_t *writer)
+{
+    (void)arena;
+
+    const context_t *ctx = data;
+    const binary_chunks_t *chunks = ctx->binary_data.chunks;
+
+    cache_writer_add(writer, &ctx->binary_data.bit_count, sizeof(ctx->binary_data.bit_count));
+    cache_writer_add(writer, chunks->items, chunks->size * sizeof(*chunks->items));
+    return true;
+}
+
+static void *load_binary_data(arena_t *arena, const cache_view_t *view)
+{
+    u64 meta_size = 0;
+    u64 size = 0;
+    const usize *bit_count = cache_section(view, 0, &meta_size);
+    i32 *items = cache_section(view, 1, &size);
+
+    if (!bit_count || meta_size != sizeof(*bit_count) || !items)
+        return NULL;
+
+    context_t *ctx = arena_alloc(arena, sizeof(*ctx));
+    binary_chunks_t *chunks = arena_alloc(arena, sizeof(*chunks));
+    if (!ctx || !chunks)
+        return NULL;
+
+    chunks->items = items;
+    chunks->size = size / sizeof(*items);
+    chunks->capacity = chunks->size;
+
+    ctx->arena = arena;
+    ctx->binary_data = (binary_data_t){ .chunks = chunks, .bit_count = *bit_count };
+
+    return ctx;
 }
 
 static i32 calculate_rating(const context_t *ctx, rating_type_t type)
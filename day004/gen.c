@@ -0,0 +1,74 @@
+#define GEN_IMPLEMENTATION
+
+#include "gen.h"
+#include <stdlib.h>
+
+// 100 cards per scale drawing from 100 numbers per scale, every number is drawn once so every
+// card wins eventually as part 2 expects
+#define CARDS_PER_SCALE 100
+#define NUMBERS_PER_SCALE 100
+#define BOARD_SIZE 5
+#define CARD_CELLS (BOARD_SIZE * BOARD_SIZE)
+
+static bool write_draws(gen_rng_t *rng, u32 numbers, FILE *out)
+{
+    u32 *draws = malloc(numbers * sizeof(*draws));
+    if (!draws)
+        return false;
+
+    for (u32 i = 0; i < numbers; ++i)
+        draws[i] = i;
+
+    gen_shuffle_u32(rng, draws, numbers);
+
+    bool written = true;
+
+    for (u32 i = 0; i < numbers && written; ++i)
+        written = fprintf(out, i > 0 ? ",%u" : "%u", draws[i]) >= 0;
+
+    free(draws);
+    return written && fputc('\n', out) != EOF;
+}
+
+static bool generate(gen_rng_t *rng, u64 scale, FILE *out)
+{
+    u32 numbers = (u32)(NUMBERS_PER_SCALE * scale);
+    int width = 1;
+
+    for (u32 n = numbers - 1; n >= 10; n /= 10)
+        ++width;
+
+    if (!write_draws(rng, numbers, out))
+        return false;
+
+    for (u64 card = 0; card < CARDS_PER_SCALE * scale; ++card) {
+        u32 cells[CARD_CELLS];
+
+        // a card never repeats a number, 25 cells are few enough to check by hand
+        for (usize i = 0; i < CARD_CELLS; ++i) {
+            bool repeated = true;
+
+            while (repeated) {
+                cells[i] = (u32)gen_below(rng, numbers);
+                repeated = false;
+
+                for (usize j = 0; j < i && !repeated; ++j)
+                    repeated = cells[j] == cells[i];
+            }
+        }
+
+        if (fputc('\n', out) == EOF)
+            return false;
+
+        for (usize i = 0; i < CARD_CELLS; ++i) {
+            char sep = (i + 1) % BOARD_SIZE == 0 ? '\n' : ' ';
+
+            if (fprintf(out, "%*u%c", width, cells[i], sep) < 0)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+GEN_MAIN(generate)
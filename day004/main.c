@@ -1,16 +1,36 @@
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 
+#ifndef AOC_RUNNER
 #define ARENA_IMPLEMENTATION
-#include "arena.h"
+#define PERF_IMPLEMENTATION
+#define TIMER_IMPLEMENTATION
 #define FILE_IMPLEMENTATION
-#include "file.h"
 #define UTILS_IMPLEMENTATION
+#define STR_IMPLEMENTATION
+#define POOL_IMPLEMENTATION
+#define HASHMAP_IMPLEMENTATION
+#define CACHE_IMPLEMENTATION
+#define LOGGER_IMPLEMENTATION
+#define DAY_IMPLEMENTATION
+#endif
+
+#include "arena.h"
+#include "perf.h"
+#include "timer.h"
+#include "file.h"
 #include "utils.h"
+#include "str.h"
+#include "pool.h"
+#include "hashmap.h"
+#include "cache.h"
 #include "logger.h"
+#include "day.h"
 
 #define ARENA_SIZE 1024
 #define FILE_NAME "day004/input.txt"
+#define CELL_REF_NONE UINT32_MAX
 
 typedef struct {
     u32 *items;
@@ -35,112 +55,118 @@ typedef struct {
     usize capacity;
 } bingo_cards_t;
 
+typedef struct {
+    u32 card;
+    u32 cell;
+    u32 next; // next cell holding the same number, in card order
+} cell_ref_t;
+
+typedef struct {
+    cell_ref_t *items;
+    usize size;
+    usize capacity;
+} cell_refs_t;
+
 typedef struct {
     selections_t selections;
     bingo_cards_t cards;
+    hashmap_t cells_by_number; // number -> first cell_ref_t holding it
+    cell_refs_t cell_refs;
 } bingo_t;
 
-typedef struct {
-    arena_t *arena;
-    const char *source;
-    bingo_t *bingo;
-} context_t;
-
-bingo_t *parse_input(arena_t *arena, const char *source);
-bool verify_bingo_card(bingo_card_t *card);
-u32 calculate_bingo_result(bingo_card_t *winning_card, u32 last_winning_number);
-void mark_bingo_card(bingo_card_t *card, u32 selection);
-void solve_part1(context_t *ctx);
-void solve_part2(context_t *ctx);
-
-int main(void)
+static void *parse_input(arena_t *arena, str_t source);
+static bool index_bingo_cells(arena_t *arena, bingo_t *bingo);
+static u32 first_cell_ref(const bingo_t *bingo, u32 number);
+static bool verify_bingo_card(bingo_card_t *card);
+static u32 calculate_bingo_result(bingo_card_t *winning_card, u32 last_winning_number);
+static bool save_bingo(arena_t *arena, void *data, cache_writer_t *writer);
+static void *load_bingo(arena_t *arena, const cache_view_t *view);
+static i64 solve_part1(void *data);
+static i64 solve_part2(void *data);
+
+const day_t day004 = {
+    .name = "day004",
+    .input = FILE_NAME,
+    .parse = parse_input,
+    .part1 = solve_part1,
+    .part2 = solve_part2,
+    .cache_version = 1,
+    .cache_save = save_bingo,
+    .cache_load = load_bingo,
+};
+
+DAY_MAIN(day004)
+
+static void *parse_input(arena_t *arena, str_t source)
 {
-    arena_t arena = { 0 };
-
-    if (!arena_create(&arena, ARENA_SIZE)) {
-        LOG(LOG_ERROR, "%s", "Failed to create arena\n");
-        return 1;
-    }
-
-    const char *source = get_input(&arena, FILE_NAME);
-
-    if (!source) {
-        LOG(LOG_ERROR, "Failed to read file '%s'", FILE_NAME);
-        arena_destroy(&arena);
-        return 1;
-    }
-
-    bingo_t *bingo = parse_input(&arena, source);
-
-    if (!bingo) {
-        LOG(LOG_ERROR, "%s", "Failed to parse input");
-        arena_destroy(&arena);
-        return 1;
-    }
-
-    context_t ctx = {
-        .arena = &arena,
-        .source = source,
-        .bingo = bingo,
-    };
+    TIMER_SCOPE("parse");
 
-    solve_part1(&ctx);
-    solve_part2(&ctx);
-
-    arena_destroy(&arena);
-
-    return 0;
-}
-
-bingo_t *parse_input(arena_t *arena, const char *source)
-{
     bingo_t *bingo = arena_alloc(arena, sizeof(*bingo));
 
     if (!bingo)
         return NULL;
 
+    // keep the numbers of neighbouring cards packed together instead of between card arrays
+    pool_t numbers_pool = { 0 };
+    if (!pool_init_type(&numbers_pool, arena, bingo_number_t, POOL_SLAB_SLOTS))
+        return NULL;
+
+    arena_t scratch = { 0 };
+    if (!arena_create(&scratch, ARENA_SIZE))
+        return NULL;
+
     selections_t selections = { 0 };
     arena_da_init(arena, &selections, ARENA_DA_CAPACITY);
 
     bingo_cards_t bingo_cards = { 0 };
     arena_da_init(arena, &bingo_cards, ARENA_DA_CAPACITY);
 
-    string_chunks_t *split_lines = split_str(arena, source, "\n\n");
+    str_chunks_t *split_lines = str_split(&scratch, source, STR("\n\n"));
     if (!split_lines)
-        return NULL;
+        goto cleanup;
 
-    string_chunks_t *selections_str = split_str(arena, split_lines->items[0], ",");
+    str_chunks_t *selections_str = str_split(&scratch, split_lines->items[0], STR(","));
     if (!selections_str)
-        return NULL;
+        goto cleanup;
 
     for (usize i = 0; i < selections_str->size; ++i) {
-        arena_da_append(arena, &selections, (u32)parse_int(selections_str->items[i], 10));
+        i64 selection = 0;
+        if (!str_parse_int(selections_str->items[i], 10, &selection))
+            goto cleanup;
+
+        arena_da_append(arena, &selections, (u32)selection);
     }
 
     for (usize i = 1; i < split_lines->size; ++i) {
-        string_chunks_t *card_str = split_str(arena, split_lines->items[i], "\n");
+        arena_scratch_t card_scratch = arena_scratch_begin(&scratch);
+
+        str_chunks_t *card_str = str_split(&scratch, split_lines->items[i], STR("\n"));
         if (!card_str)
-            return NULL;
+            goto cleanup;
 
         bingo_card_t bingo_card = { 0 };
         arena_da_init(arena, &bingo_card, ARENA_DA_CAPACITY);
 
         for (usize j = 0; j < card_str->size; ++j) {
-            string_chunks_t *numbers = split_str(arena, card_str->items[j], " ");
+            str_chunks_t *numbers = str_split(&scratch, card_str->items[j], STR(" "));
             if (!numbers)
-                return NULL;
+                goto cleanup;
 
             for (usize k = 0; k < numbers->size; ++k) {
-                const char *num_str = numbers->items[k];
+                str_t num_str = numbers->items[k];
 
-                if (strcmp(num_str, "") == 0)
+                if (num_str.len == 0)
                     continue;
 
-                bingo_number_t *bingo_number = arena_alloc(arena, sizeof(*bingo_number));
+                i64 number = 0;
+                if (!str_parse_int(num_str, 10, &number))
+                    goto cleanup;
+
+                bingo_number_t *bingo_number = pool_alloc(&numbers_pool);
                 if (!bingo_number)
-                    return NULL;
+                    goto cleanup;
 
-                bingo_number->number = (u32)parse_int(num_str, 10);
+                bingo_number->number = (u32)number;
                 bingo_number->marked = false;
 
                 arena_da_append(arena, &bingo_card, bingo_number);
@@ -148,20 +174,151 @@ bingo_t *parse_input(arena_t *arena, const char *source)
         }
 
         arena_da_append(arena, &bingo_cards, bingo_card);
+
+        arena_scratch_end(card_scratch);
     }
 
+    arena_destroy(&scratch);
+
     assert(selections.size > 0);
     assert(bingo_cards.size > 0);
 
     bingo->selections = selections;
     bingo->cards = bingo_cards;
 
+    if (!index_bingo_cells(arena, bingo))
+        return NULL;
+
+    return bingo;
+
+cleanup:
+    arena_destroy(&scratch);
+    return NULL;
+}
+
+enum {
+    BINGO_CACHE_MAP_SIZE,
+    BINGO_CACHE_SELECTIONS,
+    BINGO_CACHE_CARD_SIZES,
+    BINGO_CACHE_NUMBERS,
+    BINGO_CACHE_CELL_REFS,
+    BINGO_CACHE_MAP_KEYS,
+    BINGO_CACHE_MAP_VALUES,
+    BINGO_CACHE_MAP_DISTS,
+};
+
+// cards are flattened into their sizes and numbers, the cell index is stored as built so a
+// cached run only has to point the cards back at the numbers
+static bool save_bingo(arena_t *arena, void *data, cache_writer_t *writer)
+{
+    const bingo_t *bingo = data;
+    const hashmap_t *map = &bingo->cells_by_number;
+
+    u64 *map_size = arena_alloc(arena, sizeof(*map_size));
+    u32 *card_sizes = arena_alloc(arena, bingo->cards.size * sizeof(*card_sizes));
+    bingo_number_t *numbers = arena_alloc(arena, bingo->cell_refs.size * sizeof(*numbers));
+    if (!map_size || !card_sizes || !numbers)
+        return false;
+
+    *map_size = map->size;
+    usize cell = 0;
+
+    for (usize i = 0; i < bingo->cards.size; ++i) {
+        const bingo_card_t *card = &bingo->cards.items[i];
+        card_sizes[i] = (u32)card->size;
+
+        for (usize k = 0; k < card->size; ++k)
+            numbers[cell++] = *card->items[k];
+    }
+
+    cache_writer_add(writer, map_size, sizeof(*map_size));
+    cache_writer_add(writer, bingo->selections.items,
+                     bingo->selections.size * sizeof(*bingo->selections.items));
+    cache_writer_add(writer, card_sizes, bingo->cards.size * sizeof(*card_sizes));
+    cache_writer_add(writer, numbers, cell * sizeof(*numbers));
+    cache_writer_add(writer, bingo->cell_refs.items,
+                     bingo->cell_refs.size * sizeof(*bingo->cell_refs.items));
+    cache_writer_add(writer, map->keys, map->capacity * sizeof(*map->keys));
+    cache_writer_add(writer, map->values, map->capacity * sizeof(*map->values));
+    cache_writer_add(writer, map->dists, map->capacity * sizeof(*map->dists));
+
+    return true;
+}
+
+static void *load_bingo(arena_t *arena, const cache_view_t *view)
+{
+    u64 sizes[BINGO_CACHE_MAP_DISTS + 1] = { 0 };
+    void *sections[BINGO_CACHE_MAP_DISTS + 1] = { 0 };
+
+    for (u32 i = 0; i <= BINGO_CACHE_MAP_DISTS; ++i) {
+        sections[i] = cache_section(view, i, &sizes[i]);
+        if (!sections[i])
+            return NULL;
+    }
+
+    const u64 *map_size = sections[BINGO_CACHE_MAP_SIZE];
+    const u32 *card_sizes = sections[BINGO_CACHE_CARD_SIZES];
+    bingo_number_t *numbers = sections[BINGO_CACHE_NUMBERS];
+
+    usize card_count = sizes[BINGO_CACHE_CARD_SIZES] / sizeof(*card_sizes);
+    usize cell_count = sizes[BINGO_CACHE_NUMBERS] / sizeof(*numbers);
+    usize capacity = sizes[BINGO_CACHE_MAP_DISTS];
+
+    if (sizes[BINGO_CACHE_MAP_SIZE] != sizeof(*map_size) || card_count == 0 || capacity == 0 ||
+        (capacity & (capacity - 1)) != 0 ||
+        sizes[BINGO_CACHE_CELL_REFS] != cell_count * sizeof(cell_ref_t) ||
+        sizes[BINGO_CACHE_MAP_KEYS] != capacity * sizeof(u64) ||
+        sizes[BINGO_CACHE_MAP_VALUES] != capacity * sizeof(u64))
+        return NULL;
+
+    bingo_t *bingo = arena_alloc(arena, sizeof(*bingo));
+    bingo_card_t *cards = arena_alloc(arena, card_count * sizeof(*cards));
+    bingo_number_t **cells = arena_alloc(arena, cell_count * sizeof(*cells));
+    if (!bingo || !cards || !cells)
+        return NULL;
+
+    usize cell = 0;
+
+    for (usize i = 0; i < card_count; ++i) {
+        if (card_sizes[i] > cell_count - cell)
+            return NULL;
+
+        cards[i] = (bingo_card_t){
+            .items = cells + cell,
+            .size = card_sizes[i],
+            .capacity = card_sizes[i],
+        };
+
+        for (usize k = 0; k < card_sizes[i]; ++k, ++cell)
+            cells[cell] = &numbers[cell];
+    }
+
+    usize selection_count = sizes[BINGO_CACHE_SELECTIONS] / sizeof(u32);
+
+    *bingo = (bingo_t){
+        .selections = { .items = sections[BINGO_CACHE_SELECTIONS],
+                        .size = selection_count,
+                        .capacity = selection_count },
+        .cards = { .items = cards, .size = card_count, .capacity = card_count },
+        .cells_by_number = { .arena = arena,
+                             .keys = sections[BINGO_CACHE_MAP_KEYS],
+                             .values = sections[BINGO_CACHE_MAP_VALUES],
+                             .dists = sections[BINGO_CACHE_MAP_DISTS],
+                             .capacity = capacity,
+                             .size = *map_size },
+        .cell_refs = { .items = sections[BINGO_CACHE_CELL_REFS],
+                       .size = cell_count,
+                       .capacity = cell_count },
+    };
+
     return bingo;
 }
 
-void solve_part1(context_t *ctx)
+static i64 solve_part1(void *data)
 {
-    bingo_t *bingo = ctx->bingo;
+    TIMER_SCOPE("part1");
+
+    bingo_t *bingo = data;
 
     u32 last_selection = 0;
     usize winning_card = 0;
@@ -171,24 +328,27 @@ void solve_part1(context_t *ctx)
         u32 selection = bingo->selections.items[i];
         last_selection = selection;
 
-        for (usize j = 0; j < bingo->cards.size && !done; ++j) {
-            bingo_card_t bingo_card = bingo->cards.items[j];
-            winning_card = j;
+        for (u32 ref = first_cell_ref(bingo, selection); ref != CELL_REF_NONE && !done;
+             ref = bingo->cell_refs.items[ref].next) {
+            cell_ref_t cell = bingo->cell_refs.items[ref];
+            bingo_card_t *bingo_card = &bingo->cards.items[cell.card];
+            winning_card = cell.card;
 
-            mark_bingo_card(&bingo_card, selection);
-            done = verify_bingo_card(&bingo_card);
+            bingo_card->items[cell.cell]->marked = true;
+            done = verify_bingo_card(bingo_card);
         }
     }
 
     assert(winning_card >= 0 && winning_card < bingo->cards.size);
 
-    LOG(LOG_INFO, "Part 1 Result: %d",
-        calculate_bingo_result(&bingo->cards.items[winning_card], last_selection));
+    return calculate_bingo_result(&bingo->cards.items[winning_card], last_selection);
 }
 
-void solve_part2(context_t *ctx)
+static i64 solve_part2(void *data)
 {
-    bingo_t *bingo = ctx->bingo;
+    TIMER_SCOPE("part2");
+
+    bingo_t *bingo = data;
 
     u32 last_selection = 0;
     usize last_winning_card = 0;
@@ -202,17 +362,20 @@ void solve_part2(context_t *ctx)
         u32 selection = bingo->selections.items[i];
         last_selection = selection;
 
-        for (usize j = 0; j < bingo->cards.size && !done; ++j) {
-            if (verified_cards[j])
+        for (u32 ref = first_cell_ref(bingo, selection); ref != CELL_REF_NONE && !done;
+             ref = bingo->cell_refs.items[ref].next) {
+            cell_ref_t cell = bingo->cell_refs.items[ref];
+
+            if (verified_cards[cell.card])
                 continue;
 
-            bingo_card_t bingo_card = bingo->cards.items[j];
-            last_winning_card = j;
+            bingo_card_t *bingo_card = &bingo->cards.items[cell.card];
+            last_winning_card = cell.card;
 
-            mark_bingo_card(&bingo_card, last_selection);
+            bingo_card->items[cell.cell]->marked = true;
 
-            if (verify_bingo_card(&bingo_card)) {
-                verified_cards[j] = true;
+            if (verify_bingo_card(bingo_card)) {
+                verified_cards[cell.card] = true;
                 winners_count += 1;
             }
 
@@ -223,23 +386,50 @@ void solve_part2(context_t *ctx)
 
     assert(last_winning_card >= 0 && last_winning_card < bingo->cards.size);
 
-    LOG(LOG_INFO, "Part 2 Result: %d",
-        calculate_bingo_result(&bingo->cards.items[last_winning_card], last_selection));
+    return calculate_bingo_result(&bingo->cards.items[last_winning_card], last_selection);
 }
 
-void mark_bingo_card(bingo_card_t *card, u32 selection)
+// chains every cell holding the same number so a draw only visits the cells it marks
+static bool index_bingo_cells(arena_t *arena, bingo_t *bingo)
 {
-    for (usize k = 0; k < card->size; ++k) {
-        bingo_number_t *bingo_number = card->items[k];
+    usize cell_count = 0;
+    for (usize i = 0; i < bingo->cards.size; ++i)
+        cell_count += bingo->cards.items[i].size;
 
-        if (bingo_number->marked)
-            continue;
+    if (!hashmap_init(&bingo->cells_by_number, arena, cell_count))
+        return false;
+
+    arena_da_init(arena, &bingo->cell_refs, cell_count);
+
+    // walking the cards backwards and prepending keeps every chain in card order
+    for (usize i = bingo->cards.size; i-- > 0;) {
+        bingo_card_t *card = &bingo->cards.items[i];
+
+        for (usize k = card->size; k-- > 0;) {
+            u32 number = card->items[k]->number;
+            cell_ref_t ref = {
+                .card = (u32)i,
+                .cell = (u32)k,
+                .next = first_cell_ref(bingo, number),
+            };
+
+            arena_da_append(arena, &bingo->cell_refs, ref);
 
-        bingo_number->marked = selection == bingo_number->number;
+            if (!hashmap_put(&bingo->cells_by_number, number, bingo->cell_refs.size - 1))
+                return false;
+        }
     }
+
+    return true;
+}
+
+static u32 first_cell_ref(const bingo_t *bingo, u32 number)
+{
+    u64 *first = hashmap_get(&bingo->cells_by_number, number);
+    return first ? (u32)*first : CELL_REF_NONE;
 }
 
-u32 calculate_bingo_result(bingo_card_t *winning_card, u32 last_winning_number)
+static u32 calculate_bingo_result(bingo_card_t *winning_card, u32 last_winning_number)
 {
     u32 unmarked_values = 0;
 
@@ -255,7 +445,7 @@ u32 calculate_bingo_result(bingo_card_t *winning_card, u32 last_winning_number)
     return unmarked_values * last_winning_number;
 }
 
-bool verify_bingo_card(bingo_card_t *card)
+static bool verify_bingo_card(bingo_card_t *card)
 {
     static const usize board_size = 5;
 
@@ -0,0 +1,50 @@
+#define GEN_IMPLEMENTATION
+
+#include "gen.h"
+
+// 500 vents per scale on a square floor whose side grows with the square root of the scale,
+// so the vent density stays about the same. Horizontal, vertical and 45 degree vents are
+// equally likely
+#define VENTS_PER_SCALE 500
+#define SIDE_PER_SCALE 1000
+
+static bool generate(gen_rng_t *rng, u64 scale, FILE *out)
+{
+    i64 side = SIDE_PER_SCALE * (i64)gen_isqrt(scale);
+
+    for (u64 i = 0; i < VENTS_PER_SCALE * scale; ++i) {
+        i64 x1 = gen_range(rng, 0, side - 1);
+        i64 y1 = gen_range(rng, 0, side - 1);
+        i64 x2 = x1;
+        i64 y2 = y1;
+
+        switch (gen_below(rng, 3)) {
+        case 0: {
+            x2 = gen_range(rng, 0, side - 1);
+        } break;
+
+        case 1: {
+            y2 = gen_range(rng, 0, side - 1);
+        } break;
+
+        default: {
+            i64 step_x = gen_below(rng, 2) ? 1 : -1;
+            i64 step_y = gen_below(rng, 2) ? 1 : -1;
+            i64 room_x = step_x > 0 ? side - 1 - x1 : x1;
+            i64 room_y = step_y > 0 ? side - 1 - y1 : y1;
+            i64 length = gen_range(rng, 0, room_x < room_y ? room_x : room_y);
+
+            x2 = x1 + step_x * length;
+            y2 = y1 + step_y * length;
+        } break;
+        }
+
+        if (fprintf(out, "%lld,%lld -> %lld,%lld\n", (long long)x1, (long long)y1,
+                    (long long)x2, (long long)y2) < 0)
+            return false;
+    }
+
+    return true;
+}
+
+GEN_MAIN(generate)
@@ -1,12 +1,28 @@
+#include <assert.h>
 #include <stdlib.h>
+#include <string.h>
+
+#ifndef AOC_RUNNER
 #define ARENA_IMPLEMENTATION
-#include "arena.h"
+#define PERF_IMPLEMENTATION
+#define TIMER_IMPLEMENTATION
 #define FILE_IMPLEMENTATION
-#include "file.h"
 #define UTILS_IMPLEMENTATION
+#define STR_IMPLEMENTATION
+#define CACHE_IMPLEMENTATION
+#define LOGGER_IMPLEMENTATION
+#define DAY_IMPLEMENTATION
+#endif
+
+#include "arena.h"
+#include "perf.h"
+#include "timer.h"
+#include "file.h"
 #include "utils.h"
-#include "logger.h"
 #include "str.h"
+#include "cache.h"
+#include "logger.h"
+#include "day.h"
 
 #define ARENA_SIZE 1024
 #define FILE_NAME "day005/input.txt"
@@ -30,121 +46,170 @@ typedef struct {
     i32 height;
 } ocean_floor_t;
 
-typedef struct {
-    arena_t *arena;
-    const char *source;
-    ocean_floor_t *ocean_floor;
-} context_t;
-
-ocean_floor_t *parse_input(arena_t *arena, const char *source);
-void solve_part1(context_t *ctx);
-void solve_part2(context_t *ctx);
-void fill_diagram(i32 *diagram, usize len, ocean_floor_t *ocean_floor, bool include_diag);
-usize count_overlaps(const i32 *diagram, usize len);
-
-int main(void)
+static void *parse_input(arena_t *arena, str_t source);
+static i64 solve_part1(void *data);
+static i64 solve_part2(void *data);
+static void fill_diagram(i32 *diagram, usize len, ocean_floor_t *ocean_floor, bool include_diag);
+static usize count_overlaps(const i32 *diagram, usize len);
+static bool save_ocean_floor(arena_t *arena, void *data, cache_writer_t *writer);
+static void *load_ocean_floor(arena_t *arena, const cache_view_t *view);
+
+const day_t day005 = {
+    .name = "day005",
+    .input = FILE_NAME,
+    .parse = parse_input,
+    .part1 = solve_part1,
+    .part2 = solve_part2,
+    .cache_version = 1,
+    .cache_save = save_ocean_floor,
+    .cache_load = load_ocean_floor,
+};
+
+DAY_MAIN(day005)
+
+static void *parse_input(arena_t *arena, str_t source)
 {
-    arena_t arena = { 0 };
-
-    if (!arena_create(&arena, ARENA_SIZE)) {
-        LOG(LOG_ERROR, "%s", "Failed to create arena");
-    }
-
-    const char *source = get_input(&arena, FILE_NAME);
-
-    if (!source) {
-        LOG(LOG_ERROR, "Failed to read file '%s'", FILE_NAME);
-        arena_destroy(&arena);
-        return 1;
-    }
+    TIMER_SCOPE("parse");
 
-    ocean_floor_t *ocean_floor = parse_input(&arena, source);
-
-    if (!ocean_floor) {
-        LOG(LOG_ERROR, "%s", "Failed to parse input");
-        arena_destroy(&arena);
-        return 1;
-    }
-
-    context_t ctx = {
-        .arena = &arena,
-        .source = source,
-        .ocean_floor = ocean_floor,
-    };
-
-    solve_part1(&ctx);
-    solve_part2(&ctx);
-
-    arena_destroy(&arena);
-
-    return 0;
-}
-
-ocean_floor_t *parse_input(arena_t *arena, const char *source)
-{
     ocean_floor_t *ocean_floor = arena_alloc(arena, sizeof(*ocean_floor));
     if (!ocean_floor)
         return NULL;
 
+    // arena memory is reused between runs, the bounds below are grown from zero
+    ocean_floor->width = 0;
+    ocean_floor->height = 0;
+
+    arena_t scratch = { 0 };
+    if (!arena_create(&scratch, ARENA_SIZE))
+        return NULL;
+
     vents_t vents = { 0 };
     arena_da_init(arena, &vents, ARENA_DA_CAPACITY);
 
-    string_chunks_t *lines = split_str(arena, source, "\n");
+    split_iter_t lines = split_iter_init(source, STR("\n"));
+    str_t line = { 0 };
+
+    while (split_iter_next(&lines, &line)) {
+        arena_scratch_t line_scratch = arena_scratch_begin(&scratch);
 
-    for (usize i = 0; i < lines->size; ++i) {
-        string_chunks_t *coords = split_str(arena, lines->items[i], " -> ");
+        str_chunks_t *coords = str_split(&scratch, line, STR(" -> "));
         if (coords->size != 2)
-            return NULL;
+            goto cleanup;
 
-        string_chunks_t *point_one = split_str(arena, coords->items[0], ",");
+        str_chunks_t *point_one = str_split(&scratch, coords->items[0], STR(","));
         if (point_one->size != 2)
-            return NULL;
+            goto cleanup;
 
-        string_chunks_t *point_two = split_str(arena, coords->items[1], ",");
+        str_chunks_t *point_two = str_split(&scratch, coords->items[1], STR(","));
         if (point_one->size != 2)
-            return NULL;
+            goto cleanup;
 
-        i32 x1 = (i32)parse_int(point_one->items[0], 10);
-        i32 y1 = (i32)parse_int(point_one->items[1], 10);
-        i32 x2 = (i32)parse_int(point_two->items[0], 10);
-        i32 y2 = (i32)parse_int(point_two->items[1], 10);
+        i64 coords_one[2] = { 0 };
+        i64 coords_two[2] = { 0 };
+
+        if (!str_parse_int(point_one->items[0], 10, &coords_one[0]) ||
+            !str_parse_int(point_one->items[1], 10, &coords_one[1]) ||
+            !str_parse_int(point_two->items[0], 10, &coords_two[0]) ||
+            !str_parse_int(point_two->items[1], 10, &coords_two[1]))
+            goto cleanup;
+
+        i32 x1 = (i32)coords_one[0];
+        i32 y1 = (i32)coords_one[1];
+        i32 x2 = (i32)coords_two[0];
+        i32 y2 = (i32)coords_two[1];
 
         ocean_floor->width = MAX(ocean_floor->width, MAX(x1, x2) + 1);
         ocean_floor->height = MAX(ocean_floor->height, MAX(y1, y2) + 1);
 
         points_t points = { x1, y1, x2, y2 };
         arena_da_append(arena, &vents, points);
+
+        arena_scratch_end(line_scratch);
     }
 
+    arena_destroy(&scratch);
+
     assert(vents.size >= 0);
     ocean_floor->vents = vents;
 
+    return ocean_floor;
+
+cleanup:
+    arena_destroy(&scratch);
+    return NULL;
+}
+
+// the floor bounds go first as their own section, the vents follow
+static bool save_ocean_floor(arena_t *arena, void *data, cache_writer_t *writer)
+{
+    const ocean_floor_t *ocean_floor = data;
+
+    i32 *bounds = arena_alloc(arena, 2 * sizeof(*bounds));
+    if (!bounds)
+        return false;
+
+    bounds[0] = ocean_floor->width;
+    bounds[1] = ocean_floor->height;
+
+    cache_writer_add(writer, bounds, 2 * sizeof(*bounds));
+    cache_writer_add(writer, ocean_floor->vents.items,
+                     ocean_floor->vents.size * sizeof(*ocean_floor->vents.items));
+    return true;
+}
+
+static void *load_ocean_floor(arena_t *arena, const cache_view_t *view)
+{
+    u64 bounds_size = 0;
+    u64 size = 0;
+    const i32 *bounds = cache_section(view, 0, &bounds_size);
+    points_t *items = cache_section(view, 1, &size);
+
+    if (!bounds || bounds_size != 2 * sizeof(*bounds) || !items)
+        return NULL;
+
+    ocean_floor_t *ocean_floor = arena_alloc(arena, sizeof(*ocean_floor));
+    if (!ocean_floor)
+        return NULL;
+
+    usize count = size / sizeof(*items);
+
+    ocean_floor->width = bounds[0];
+    ocean_floor->height = bounds[1];
+    ocean_floor->vents = (vents_t){ .items = items, .size = count, .capacity = count };
+
     return ocean_floor;
 }
 
-void solve_part1(context_t *ctx)
+static i64 solve_part1(void *data)
 {
-    i32 diagram[ctx->ocean_floor->width * ctx->ocean_floor->height];
+    TIMER_SCOPE("part1");
+
+    ocean_floor_t *ocean_floor = data;
+    i32 diagram[ocean_floor->width * ocean_floor->height];
     usize diagram_len = sizeof(diagram) / sizeof(*diagram);
     memset(diagram, 0, sizeof(diagram));
 
-    fill_diagram(diagram, diagram_len, ctx->ocean_floor, false);
+    fill_diagram(diagram, diagram_len, ocean_floor, false);
 
-    LOG(LOG_INFO, "Part 1 Overlaps: %zu", count_overlaps(diagram, diagram_len));
+    return (i64)count_overlaps(diagram, diagram_len);
 }
 
-void solve_part2(context_t *ctx)
+static i64 solve_part2(void *data)
 {
-    i32 diagram[ctx->ocean_floor->width * ctx->ocean_floor->height];
+    TIMER_SCOPE("part2");
+
+    ocean_floor_t *ocean_floor = data;
+    i32 diagram[ocean_floor->width * ocean_floor->height];
     usize diagram_len = sizeof(diagram) / sizeof(*diagram);
     memset(diagram, 0, sizeof(diagram));
 
-    fill_diagram(diagram, diagram_len, ctx->ocean_floor, true);
+    fill_diagram(diagram, diagram_len, ocean_floor, true);
 
-    LOG(LOG_INFO, "Part 2 Overlaps: %zu", count_overlaps(diagram, diagram_len));
+    return (i64)count_overlaps(diagram, diagram_len);
 }
 
-void fill_diagram(i32 *diagram, usize diagram_len, ocean_floor_t *ocean_floor, bool include_diag)
+static void fill_diagram(i32 *diagram, usize diagram_len, ocean_floor_t *ocean_floor,
+                         bool include_diag)
 {
     for (usize i = 0; i < ocean_floor->vents.size; ++i) {
         points_t points = ocean_floor->vents.items[i];
@@ -187,7 +252,7 @@ void fill_diagram(i32 *diagram, usize diagram_len, ocean_floor_t *ocean_floor, b
     }
 }
 
-usize count_overlaps(const i32 *diagram, usize len)
+static usize count_overlaps(const i32 *diagram, usize len)
 {
     usize overlaps = 0;
     for (usize i = 0; i < len; ++i) {
@@ -0,0 +1,20 @@
+#define GEN_IMPLEMENTATION
+
+#include "gen.h"
+
+// 300 lanternfish per scale on one line, mostly fresh timers of 1 like the puzzle input
+#define FISH_PER_SCALE 300
+
+static bool generate(gen_rng_t *rng, u64 scale, FILE *out)
+{
+    for (u64 i = 0; i < FISH_PER_SCALE * scale; ++i) {
+        i64 timer = gen_below(rng, 10) < 6 ? 1 : gen_range(rng, 2, 5);
+
+        if (fprintf(out, i > 0 ? ",%lld" : "%lld", (long long)timer) < 0)
+            return false;
+    }
+
+    return fputc('\n', out) != EOF;
+}
+
+GEN_MAIN(generate)
@@ -1,69 +1,127 @@
+#include <string.h>
+
+#ifndef AOC_RUNNER
 #define ARENA_IMPLEMENTATION
-#include "arena.h"
+#define PERF_IMPLEMENTATION
+#define TIMER_IMPLEMENTATION
 #define FILE_IMPLEMENTATION
-#include "file.h"
 #define UTILS_IMPLEMENTATION
+#define STR_IMPLEMENTATION
+#define CACHE_IMPLEMENTATION
+#define LOGGER_IMPLEMENTATION
+#define DAY_IMPLEMENTATION
+#endif
+
+#include "arena.h"
+#include "perf.h"
+#include "timer.h"
+#include "file.h"
 #include "utils.h"
-#include "logger.h"
 #include "str.h"
+#include "cache.h"
+#include "logger.h"
+#include "day.h"
 
-#define ARENA_SIZE 1024
 #define FILE_NAME "day006/input.txt"
 #define TIMERS_LEN 9
 
-u64 *parse_input(arena_t *arena, const char *source);
-void solve(const u64 *input, usize days);
-
-int main(void)
+static void *parse_input(arena_t *arena, str_t source);
+static void *parse_input_stream(arena_t *arena, line_reader_t *reader);
+static i64 solve_part1(void *data);
+static i64 solve_part2(void *data);
+static u64 simulate(const u64 *input, usize days);
+
+// only the timer histogram is kept, so a file input is streamed instead of loaded
+const day_t day006 = {
+    .name = "day006",
+    .input = FILE_NAME,
+    .parse = parse_input,
+    .parse_stream = parse_input_stream,
+    .stream_delim = ',',
+    .part1 = solve_part1,
+    .part2 = solve_part2,
+};
+
+DAY_MAIN(day006)
+
+static u64 *alloc_timers(arena_t *arena)
 {
-    arena_t arena = { 0 };
+    u64 *timers = arena_alloc(arena, TIMERS_LEN * sizeof(*timers));
+    if (!timers)
+        return NULL;
 
-    if (!arena_create(&arena, ARENA_SIZE)) {
-        LOG(LOG_ERROR, "%s", "Failed to create arena");
-    }
+    memset(timers, 0, TIMERS_LEN * sizeof(*timers));
 
-    const char *source = get_input(&arena, FILE_NAME);
+    return timers;
+}
 
-    if (!source) {
-        LOG(LOG_ERROR, "Failed to read file '%s'", FILE_NAME);
-        arena_destroy(&arena);
-        return 1;
-    }
+static bool count_timer(u64 *timers, i64 timer)
+{
+    if (timer < 0 || timer >= TIMERS_LEN)
+        return false;
+
+    timers[timer] += 1;
+    return true;
+}
 
-    u64 *timers = parse_input(&arena, source);
+static void *parse_input(arena_t *arena, str_t source)
+{
+    TIMER_SCOPE("parse");
 
-    if (!timers) {
-        LOG(LOG_ERROR, "%s", "Failed to parse input");
-        arena_destroy(&arena);
-        return 1;
-    }
+    u64 *timers = alloc_timers(arena);
+    if (!timers)
+        return NULL;
 
-    solve(timers, 80);
-    solve(timers, 256);
+    split_iter_t records = split_iter_init(source, STR(","));
+    str_t record = { 0 };
 
-    arena_destroy(&arena);
+    while (split_iter_next(&records, &record)) {
+        i64 timer = 0;
 
-    return 0;
+        if (!str_parse_int(str_trim(record), 10, &timer) || !count_timer(timers, timer))
+            return NULL;
+    }
+
+    return timers;
 }
 
-u64 *parse_input(arena_t *arena, const char *source)
+static void *parse_input_stream(arena_t *arena, line_reader_t *reader)
 {
-    u64 *timers = arena_alloc(arena, TIMERS_LEN * sizeof(*timers));
+    TIMER_SCOPE("parse");
+
+    u64 *timers = alloc_timers(arena);
     if (!timers)
         return NULL;
 
-    memset(timers, 0, TIMERS_LEN * sizeof(*timers));
+    char *record = NULL;
+    usize record_len = 0;
 
-    string_chunks_t *chunks = split_str(arena, source, ",");
+    while (line_reader_next(reader, &record, &record_len)) {
+        str_t timer_str = str_trim((str_t){ .data = record, .len = record_len });
+        i64 timer = 0;
 
-    for (usize i = 0; i < chunks->size; ++i) {
-        timers[(u64)parse_int(trim(chunks->items[i]), 10)] += 1;
+        if (!str_parse_int(timer_str, 10, &timer) || !count_timer(timers, timer))
+            return NULL;
     }
 
     return timers;
 }
 
-void solve(const u64 *input, usize days)
+static i64 solve_part1(void *data)
+{
+    TIMER_SCOPE("part1");
+
+    return (i64)simulate(data, 80);
+}
+
+static i64 solve_part2(void *data)
+{
+    TIMER_SCOPE("part2");
+
+    return (i64)simulate(data, 256);
+}
+
+static u64 simulate(const u64 *input, usize days)
 {
     u64 timers[TIMERS_LEN];
     memcpy(timers, input, sizeof(timers));
@@ -82,10 +140,10 @@ void solve(const u64 *input, usize days)
         timers[8] = spawn;
     }
 
-    usize count = 0;
+    u64 count = 0;
 
     for (usize i = 0; i < TIMERS_LEN; ++i)
         count += timers[i];
 
-    LOG(LOG_INFO, "%zu Days: %zu", days, count);
+    return count;
 }
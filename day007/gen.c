@@ -0,0 +1,26 @@
+#define GEN_IMPLEMENTATION
+
+#include "gen.h"
+
+// 1000 crabs per scale on one line, positions skewed towards zero like the puzzle input.
+// The range grows with the square root of the scale since part 2 scans every position
+#define CRABS_PER_SCALE 1000
+#define RANGE_PER_SCALE 2000
+
+static bool generate(gen_rng_t *rng, u64 scale, FILE *out)
+{
+    u64 range = RANGE_PER_SCALE * gen_isqrt(scale);
+
+    for (u64 i = 0; i < CRABS_PER_SCALE * scale; ++i) {
+        u64 a = gen_below(rng, range);
+        u64 b = gen_below(rng, range);
+        u64 position = a < b ? a : b;
+
+        if (fprintf(out, i > 0 ? ",%llu" : "%llu", (unsigned long long)position) < 0)
+            return false;
+    }
+
+    return fputc('\n', out) != EOF;
+}
+
+GEN_MAIN(generate)
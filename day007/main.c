@@ -1,15 +1,34 @@
+#include <assert.h>
 #include <stdint.h>
+
+#ifndef AOC_RUNNER
 #define ARENA_IMPLEMENTATION
-#include "arena.h"
+#define PERF_IMPLEMENTATION
+#define TIMER_IMPLEMENTATION
 #define FILE_IMPLEMENTATION
-#include "file.h"
 #define UTILS_IMPLEMENTATION
+#define STR_IMPLEMENTATION
+#define THREAD_POOL_IMPLEMENTATION
+#define PARALLEL_SPLIT_IMPLEMENTATION
+#define CACHE_IMPLEMENTATION
+#define LOGGER_IMPLEMENTATION
+#define DAY_IMPLEMENTATION
+#endif
+
+#include "arena.h"
+#include "perf.h"
+#include "timer.h"
+#include "file.h"
 #include "utils.h"
-#include "logger.h"
 #include "str.h"
+#include "thread_pool.h"
+#include "parallel_split.h"
+#include "cache.h"
+#include "logger.h"
+#include "day.h"
 
-#define ARENA_SIZE 1024
 #define FILE_NAME "day007/input.txt"
+#define FUEL_SEARCH_GRAIN 16
 
 typedef struct {
     u64 *items;
@@ -21,99 +40,168 @@ typedef struct {
     positions_t positions;
     u64 min;
     u64 max;
+    u64 median;
 } context_t;
 
-context_t *parse_input(arena_t *arena, const char *source);
-void solve_part1(const context_t *context);
-void solve_part2(const context_t *context);
-inline u64 abs_diff(u64 a, u64 b);
-
-int main(void)
+typedef struct {
+    const context_t *context;
+    u64 min_fuel[THREAD_POOL_MAX_THREADS]; // per worker
+} fuel_search_t;
+
+static void *parse_input(arena_t *arena, str_t source);
+static bool parse_positions(void *context, arena_t *arena, arena_t *scratch, str_t chunk,
+                            parallel_segment_t *segment);
+static i64 solve_part1(void *data);
+static i64 solve_part2(void *data);
+static void search_min_fuel(void *data, const thread_pool_range_t *range);
+static inline u64 abs_diff(u64 a, u64 b);
+static bool save_positions(arena_t *arena, void *data, cache_writer_t *writer);
+static void *load_positions(arena_t *arena, const cache_view_t *view);
+
+const day_t day007 = {
+    .name = "day007",
+    .input = FILE_NAME,
+    .parse = parse_input,
+    .part1 = solve_part1,
+    .part2 = solve_part2,
+    .cache_version = 1,
+    .cache_save = save_positions,
+    .cache_load = load_positions,
+};
+
+DAY_MAIN(day007)
+
+static void *parse_input(arena_t *arena, str_t source)
 {
-    arena_t arena = { 0 };
+    TIMER_SCOPE("parse");
 
-    if (!arena_create(&arena, ARENA_SIZE)) {
-        LOG(LOG_ERROR, "%s", "Failed to create arena");
-    }
+    context_t *context = arena_alloc(arena, sizeof(*context));
+    if (!context)
+        return NULL;
 
-    const char *source = get_input(&arena, FILE_NAME);
+    context->max = 0;
+    context->min = UINT64_MAX;
 
-    if (!source) {
-        LOG(LOG_ERROR, "Failed to read file '%s'", FILE_NAME);
-        arena_destroy(&arena);
-        return 1;
-    }
+    positions_t positions = { 0 };
+    positions.items = parallel_split(thread_pool_default(), arena, source, ',',
+                                     sizeof(*positions.items), parse_positions, NULL,
+                                     &positions.size);
+    if (!positions.items)
+        return NULL;
 
-    context_t *context = parse_input(&arena, source);
+    positions.capacity = positions.size;
 
-    if (!context) {
-        LOG(LOG_ERROR, "%s", "Failed to parse input");
-        arena_destroy(&arena);
-        return 1;
+    for (usize i = 0; i < positions.size; ++i) {
+        context->max = MAX(context->max, positions.items[i]);
+        context->min = MIN(context->min, positions.items[i]);
     }
 
-    solve_part1(context);
-    solve_part2(context);
+    assert(positions.size > 0);
 
-    arena_destroy(&arena);
+    // any median minimises the sum of absolute distances, selecting reorders positions in place
+    context->median = select_nth_u64(positions.items, positions.size, positions.size / 2);
+    context->positions = positions;
 
-    return 0;
+    return context;
 }
 
-context_t *parse_input(arena_t *arena, const char *source)
+static bool parse_positions(void *context, arena_t *arena, arena_t *scratch, str_t chunk,
+                            parallel_segment_t *segment)
 {
-    context_t *context = arena_alloc(arena, sizeof(*context));
-    if (!context)
-        return NULL;
+    (void)context, (void)scratch;
 
-    context->max = 0;
-    context->min = UINT64_MAX;
+    segment->items = parse_u64_list(arena, chunk.data, chunk.len, ',', &segment->count);
+    return segment->items != NULL;
+}
 
-    string_chunks_t *chunks = split_str(arena, source, ",");
+// min, max and median go first as their own section, the positions follow already selected
+static bool save_positions(arena_t *arena, void *data, cache_writer_t *writer)
+{
+    const context_t *context = data;
 
-    positions_t positions = { 0 };
-    arena_da_init(arena, &positions, chunks->size);
+    u64 *stats = arena_alloc(arena, 3 * sizeof(*stats));
+    if (!stats)
+        return false;
 
-    for (usize i = 0; i < chunks->size; ++i) {
-        u64 num = (u64)parse_int(trim(chunks->items[i]), 10);
-        context->max = MAX(context->max, num);
-        context->min = MIN(context->min, num);
+    stats[0] = context->min;
+    stats[1] = context->max;
+    stats[2] = context->median;
 
-        arena_da_append(arena, &positions, num);
-    }
+    cache_writer_add(writer, stats, 3 * sizeof(*stats));
+    cache_writer_add(writer, context->positions.items,
+                     context->positions.size * sizeof(*context->positions.items));
+    return true;
+}
 
-    assert(positions.size > 0);
+static void *load_positions(arena_t *arena, const cache_view_t *view)
+{
+    u64 stats_size = 0;
+    u64 size = 0;
+    const u64 *stats = cache_section(view, 0, &stats_size);
+    u64 *items = cache_section(view, 1, &size);
 
-    context->positions = positions;
+    if (!stats || stats_size != 3 * sizeof(*stats) || !items || size == 0)
+        return NULL;
+
+    context_t *context = arena_alloc(arena, sizeof(*context));
+    if (!context)
+        return NULL;
+
+    usize count = size / sizeof(*items);
+
+    context->min = stats[0];
+    context->max = stats[1];
+    context->median = stats[2];
+    context->positions = (positions_t){ .items = items, .size = count, .capacity = count };
 
     return context;
 }
 
-void solve_part1(const context_t *context)
+static i64 solve_part1(void *data)
 {
-    u64 min_fuel_count = UINT64_MAX;
+    TIMER_SCOPE("part1");
 
-    // maybe much more efficient to get the median of a sorted list
-    for (u64 i = context->min; i <= context->max; ++i) {
-        u64 sum = 0;
-        for (usize j = 0; j < context->positions.size; ++j) {
-            sum += abs_diff(context->positions.items[j], i);
-        }
+    const context_t *context = data;
+    u64 min_fuel_count = 0;
 
-        min_fuel_count = MIN(min_fuel_count, sum);
+    for (usize i = 0; i < context->positions.size; ++i) {
+        min_fuel_count += abs_diff(context->positions.items[i], context->median);
     }
 
-    LOG(LOG_INFO, "Part 1: %llu", min_fuel_count);
+    return (i64)min_fuel_count;
 }
 
-void solve_part2(const context_t *context)
+static i64 solve_part2(void *data)
 {
+    TIMER_SCOPE("part2");
+
+    fuel_search_t search = { .context = data };
+
+    for (usize i = 0; i < THREAD_POOL_MAX_THREADS; ++i)
+        search.min_fuel[i] = UINT64_MAX;
+
+    // every candidate costs a pass over all crabs, so they are spread over the workers
+    thread_pool_parallel_for(thread_pool_default(), search.context->min, search.context->max + 1,
+                             FUEL_SEARCH_GRAIN, search_min_fuel, &search);
+
     u64 min_fuel_count = UINT64_MAX;
 
-    for (u64 i = context->min; i <= context->max; ++i) {
+    for (usize i = 0; i < THREAD_POOL_MAX_THREADS; ++i)
+        min_fuel_count = MIN(min_fuel_count, search.min_fuel[i]);
+
+    return (i64)min_fuel_count;
+}
+
+static void search_min_fuel(void *data, const thread_pool_range_t *range)
+{
+    fuel_search_t *search = data;
+    const positions_t *positions = &search->context->positions;
+    u64 min_fuel_count = search->min_fuel[range->worker];
+
+    for (u64 i = range->begin; i < range->end; ++i) {
         u64 sum = 0;
-        for (usize j = 0; j < context->positions.size; ++j) {
-            u64 diff = abs_diff(context->positions.items[j], i);
+        for (usize j = 0; j < positions->size; ++j) {
+            u64 diff = abs_diff(positions->items[j], i);
 
             sum += diff * (diff + 1) / 2;
         }
@@ -121,10 +209,10 @@ void solve_part2(const context_t *context)
         min_fuel_count = MIN(min_fuel_count, sum);
     }
 
-    LOG(LOG_INFO, "Part 2: %llu", min_fuel_count);
+    search->min_fuel[range->worker] = min_fuel_count;
 }
 
-inline u64 abs_diff(u64 a, u64 b)
+static inline u64 abs_diff(u64 a, u64 b)
 {
     return a > b ? a - b : b - a;
 }
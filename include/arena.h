@@ -2,26 +2,64 @@
 
 #include "type_defs.h"
 #include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef enum {
+    ARENA_VIRTUAL = 1 << 0,    // capacity is reserved address space, pages are committed on demand
+    ARENA_HUGE_PAGES = 1 << 1, // ask for transparent huge pages on a virtual arena
+} arena_flags_t;
+
+#ifdef ARENA_STATS
+typedef struct {
+    usize allocations;
+    usize bytes_requested;
+    usize bytes_padding;        // lost to alignment
+    usize bytes_wasted_tail;    // left unused at the end of a block when moving to the next
+    usize bytes_realloc_copied; // old buffers abandoned by copying arena_realloc calls
+    usize bytes_reserved;       // capacity of every block in the chain
+    usize blocks;
+    usize in_use;
+    usize peak;
+} arena_stats_t;
+#endif
 
 typedef struct arena {
     unsigned char *base;
     usize capacity;
     usize offset;
+    usize committed;
+    u32 flags;
     struct arena *next;
+    struct arena *tail; // block currently bumped into, only tracked on the head
+    usize reclaimed;    // bytes arena_realloc did not have to leave behind, head only
+#ifdef ARENA_STATS
+    arena_stats_t stats; // head only
+#endif
 } arena_t;
 
+typedef struct {
+    arena_t *block;
+    usize offset;
+} arena_mark_t;
+
+typedef struct {
+    arena_t *arena;
+    arena_mark_t mark;
+} arena_scratch_t;
+
 bool arena_create(arena_t *arena, usize capacity);
+bool arena_create_virtual(arena_t *arena, usize reserve, u32 flags);
 void *arena_alloc(arena_t *arena, usize size);
+void *arena_alloc_aligned(arena_t *arena, usize size, usize align);
 void *arena_realloc(arena_t *arena, void *ptr, usize old_size, usize size);
+arena_mark_t arena_mark(arena_t *arena);
+void arena_rewind(arena_t *arena, arena_mark_t mark);
+arena_scratch_t arena_scratch_begin(arena_t *arena);
+void arena_scratch_end(arena_scratch_t scratch);
 void arena_clean(arena_t *arena);
 void arena_destroy(arena_t *arena);
-
-#ifdef ARENA_IMPLEMENTATION
-
-#include <assert.h>
-#include <stdlib.h>
-#include <stdint.h>
-#include <string.h>
+void arena_stats_dump(const arena_t *arena, FILE *out);
 
 #define ARENA_DA_CAPACITY 256
 
@@ -52,6 +90,64 @@ void arena_destroy(arena_t *arena);
         (da)->items[(da)->size++] = (item);                                                   \
     } while (0)
 
+#ifdef ARENA_IMPLEMENTATION
+
+#include <assert.h>
+#include <stdalign.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define ARENA_HAS_VIRTUAL 1
+#endif
+
+#ifndef ARENA_COMMIT_SIZE
+#define ARENA_COMMIT_SIZE (64 * 1024)
+#endif
+
+#ifndef ARENA_HUGE_PAGE_SIZE
+#define ARENA_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#endif
+
+#ifndef ARENA_DEFAULT_ALIGNMENT
+#define ARENA_DEFAULT_ALIGNMENT alignof(max_align_t)
+#endif
+
+static void arena_stats_alloc(arena_t *arena, usize size, usize padding)
+{
+#ifdef ARENA_STATS
+    arena->stats.allocations += 1;
+    arena->stats.bytes_requested += size;
+    arena->stats.bytes_padding += padding;
+    arena->stats.in_use += padding + size;
+    if (arena->stats.in_use > arena->stats.peak)
+        arena->stats.peak = arena->stats.in_use;
+#else
+    (void)arena, (void)size, (void)padding;
+#endif
+}
+
+static void arena_stats_release(arena_t *arena, usize size)
+{
+#ifdef ARENA_STATS
+    arena->stats.in_use -= size < arena->stats.in_use ? size : arena->stats.in_use;
+#else
+    (void)arena, (void)size;
+#endif
+}
+
+static void arena_stats_block(arena_t *arena, usize capacity)
+{
+#ifdef ARENA_STATS
+    arena->stats.blocks += 1;
+    arena->stats.bytes_reserved += capacity;
+#else
+    (void)arena, (void)capacity;
+#endif
+}
+
 bool arena_create(arena_t *arena, usize capacity)
 {
     if (!arena || capacity == 0)
@@ -63,36 +159,156 @@ bool arena_create(arena_t *arena, usize capacity)
 
     arena->capacity = capacity;
     arena->offset = 0;
+    arena->committed = capacity;
+    arena->flags = 0;
     arena->next = NULL;
+    arena->tail = arena;
+    arena->reclaimed = 0;
+#ifdef ARENA_STATS
+    arena->stats = (arena_stats_t){ 0 };
+#endif
+    arena_stats_block(arena, capacity);
     return true;
 }
 
+static usize arena_commit_granularity(const arena_t *block)
+{
+    return block->flags & ARENA_HUGE_PAGES ? ARENA_HUGE_PAGE_SIZE : ARENA_COMMIT_SIZE;
+}
+
+bool arena_create_virtual(arena_t *arena, usize reserve, u32 flags)
+{
+#ifdef ARENA_HAS_VIRTUAL
+    if (!arena || reserve == 0)
+        return false;
+
+    arena->flags = flags | ARENA_VIRTUAL;
+
+    usize granularity = arena_commit_granularity(arena);
+    reserve = (reserve + granularity - 1) / granularity * granularity;
+
+    int map_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+    map_flags |= MAP_NORESERVE;
+#endif
+
+    // over-reserve by one granule so the base can be aligned for huge pages
+    usize mapped = reserve + granularity;
+    unsigned char *region = mmap(NULL, mapped, PROT_NONE, map_flags, -1, 0);
+    if (region == MAP_FAILED)
+        return false;
+
+    uptr aligned = ((uptr)region + granularity - 1) & ~(uptr)(granularity - 1);
+    unsigned char *base = (unsigned char *)aligned;
+    usize head = (usize)(base - region);
+
+    if (head > 0)
+        munmap(region, head);
+    if (mapped - head > reserve)
+        munmap(base + reserve, mapped - head - reserve);
+
+#ifdef MADV_HUGEPAGE
+    if (flags & ARENA_HUGE_PAGES)
+        madvise(base, reserve, MADV_HUGEPAGE);
+#endif
+
+    arena->base = base;
+    arena->capacity = reserve;
+    arena->offset = 0;
+    arena->committed = 0;
+    arena->next = NULL;
+    arena->tail = arena;
+    arena->reclaimed = 0;
+#ifdef ARENA_STATS
+    arena->stats = (arena_stats_t){ 0 };
+#endif
+    arena_stats_block(arena, reserve);
+    return true;
+#else
+    (void)flags;
+    return arena_create(arena, reserve);
+#endif
+}
+
+static bool arena_commit(arena_t *block, usize top)
+{
+    if (top <= block->committed)
+        return true;
+
+#ifdef ARENA_HAS_VIRTUAL
+    usize granularity = arena_commit_granularity(block);
+    usize committed = (top + granularity - 1) / granularity * granularity;
+    if (committed > block->capacity)
+        committed = block->capacity;
+
+    if (mprotect(block->base + block->committed, committed - block->committed,
+                 PROT_READ | PROT_WRITE) != 0)
+        return false;
+
+    block->committed = committed;
+    return true;
+#else
+    return false;
+#endif
+}
+
+static usize arena_padding(const arena_t *block, usize align)
+{
+    uptr addr = (uptr)(block->base + block->offset);
+    return (usize)(-addr & (align - 1));
+}
+
 void *arena_alloc(arena_t *arena, usize size)
+{
+    return arena_alloc_aligned(arena, size, ARENA_DEFAULT_ALIGNMENT);
+}
+
+void *arena_alloc_aligned(arena_t *arena, usize size, usize align)
 {
     if (!arena || !arena->base || size == 0)
         return NULL;
 
-    arena_t *end = arena;
-    while (end->next)
-        end = end->next;
+    assert(align != 0 && (align & (align - 1)) == 0);
+
+    arena_t *end = arena->tail ? arena->tail : arena;
+    usize padding = arena_padding(end, align);
 
-    if (end->offset + size > end->capacity) {
-        arena_t *next = malloc(sizeof(*next));
-        if (!next)
-            return NULL;
+    // blocks past the tail are only left over from arena_clean, reuse them before chaining
+    while (end->offset + padding + size > end->capacity) {
+        if (!end->next) {
+            arena_t *next = malloc(sizeof(*next));
+            if (!next)
+                return NULL;
 
-        usize new_cap = size > end->capacity * 2 ? size : end->capacity * 2;
-        if (!arena_create(next, new_cap)) {
-            free(next);
-            return NULL;
+            usize needed = size + align - 1;
+            usize new_cap = needed > end->capacity * 2 ? needed : end->capacity * 2;
+            bool created = end->flags & ARENA_VIRTUAL ?
+                               arena_create_virtual(next, new_cap, end->flags) :
+                               arena_create(next, new_cap);
+            if (!created) {
+                free(next);
+                return NULL;
+            }
+
+            end->next = next;
+            arena_stats_block(arena, new_cap);
         }
 
-        end->next = next;
-        end = next;
+#ifdef ARENA_STATS
+        arena->stats.bytes_wasted_tail += end->capacity - end->offset;
+#endif
+        end = end->next;
+        padding = arena_padding(end, align);
     }
 
-    void *ptr = end->base + end->offset;
-    end->offset += size;
+    if (!arena_commit(end, end->offset + padding + size))
+        return NULL;
+
+    arena->tail = end;
+
+    void *ptr = end->base + end->offset + padding;
+    end->offset += padding + size;
+    arena_stats_alloc(arena, size, padding);
 
     return ptr;
 }
@@ -101,19 +317,82 @@ void *arena_realloc(arena_t *arena, void *oldptr, usize old_size, usize new_size
 {
     assert(old_size != 0);
 
-    if (new_size <= old_size)
+    arena_t *end = arena->tail ? arena->tail : arena;
+    unsigned char *old_bytes = oldptr;
+    bool is_last = old_bytes >= end->base && old_bytes + old_size == end->base + end->offset;
+
+    if (new_size <= old_size) {
+        if (is_last) {
+            end->offset -= old_size - new_size;
+            arena->reclaimed += old_size - new_size;
+            arena_stats_release(arena, old_size - new_size);
+        }
+
+        return oldptr;
+    }
+
+    // growing the most recent allocation only needs to bump the offset
+    if (is_last && end->offset - old_size + new_size <= end->capacity &&
+        arena_commit(end, end->offset - old_size + new_size)) {
+        end->offset += new_size - old_size;
+        arena->reclaimed += old_size;
+        arena_stats_alloc(arena, new_size - old_size, 0);
         return oldptr;
+    }
 
     void *newptr = arena_alloc(arena, new_size);
     if (!newptr)
         return NULL;
 
     memcpy(newptr, oldptr, old_size);
+#ifdef ARENA_STATS
+    arena->stats.bytes_realloc_copied += old_size;
+#endif
     return newptr;
 }
 
+arena_mark_t arena_mark(arena_t *arena)
+{
+    arena_t *end = arena->tail ? arena->tail : arena;
+    return (arena_mark_t){ .block = end, .offset = end->offset };
+}
+
+void arena_rewind(arena_t *arena, arena_mark_t mark)
+{
+    arena_t *end = arena->tail ? arena->tail : arena;
+
+    // everything chained after the marked block was allocated after the mark
+    for (arena_t *block = mark.block->next; block && block != end->next; block = block->next) {
+        arena_stats_release(arena, block->offset);
+        block->offset = 0;
+    }
+
+    assert(mark.offset <= mark.block->offset);
+    arena_stats_release(arena, mark.block->offset - mark.offset);
+    mark.block->offset = mark.offset;
+    arena->tail = mark.block;
+}
+
+arena_scratch_t arena_scratch_begin(arena_t *arena)
+{
+    return (arena_scratch_t){ .arena = arena, .mark = arena_mark(arena) };
+}
+
+void arena_scratch_end(arena_scratch_t scratch)
+{
+    arena_rewind(scratch.arena, scratch.mark);
+}
+
 void arena_clean(arena_t *arena)
 {
+    if (!arena)
+        return;
+
+    arena->tail = arena;
+#ifdef ARENA_STATS
+    arena->stats.in_use = 0;
+#endif
+
     while (arena) {
         arena->offset = 0;
         arena = arena->next;
@@ -125,10 +404,19 @@ void arena_destroy(arena_t *arena)
     if (!arena)
         return;
 
+#ifdef ARENA_HAS_VIRTUAL
+    if (arena->flags & ARENA_VIRTUAL)
+        munmap(arena->base, arena->capacity);
+    else
+        free(arena->base);
+#else
     free(arena->base);
+#endif
     arena->base = NULL;
     arena->capacity = 0;
     arena->offset = 0;
+    arena->committed = 0;
+    arena->tail = NULL;
 
     if (arena->next) {
         arena_destroy(arena->next);
@@ -137,4 +425,32 @@ void arena_destroy(arena_t *arena)
     }
 }
 
+void arena_stats_dump(const arena_t *arena, FILE *out)
+{
+#ifdef ARENA_STATS
+    if (!arena || !out)
+        return;
+
+    const arena_stats_t *stats = &arena->stats;
+    usize used = 0;
+    usize committed = 0;
+
+    for (const arena_t *block = arena; block; block = block->next) {
+        used += block->offset;
+        committed += block->committed;
+    }
+
+    fprintf(out, "arena: %zu allocations, %zu bytes requested\n", stats->allocations,
+            stats->bytes_requested);
+    fprintf(out, "arena: %zu blocks, %zu bytes reserved, %zu committed, %zu in use\n",
+            stats->blocks, stats->bytes_reserved, committed, used);
+    fprintf(out, "arena: %zu peak, %zu padding, %zu wasted tail space\n", stats->peak,
+            stats->bytes_padding, stats->bytes_wasted_tail);
+    fprintf(out, "arena: %zu bytes left behind by realloc copies, %zu reclaimed in place\n",
+            stats->bytes_realloc_copied, arena->reclaimed);
+#else
+    (void)arena, (void)out;
+#endif
+}
+
 #endif // ARENA_IMPLEMENTATION
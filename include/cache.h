@@ -0,0 +1,373 @@
+#pragma once
+
+#include "type_defs.h"
+#include <stdbool.h>
+
+// binary cache of parsed inputs, opt in by pointing AOC_CACHE at a directory
+//
+//     AOC_CACHE=build/cache build/runner all
+//
+// a day hands its parsed arrays to a cache_writer_t as sections, they are written once, 64 byte
+// aligned, to <dir>/<day>-<input hash>.bin. Later runs of the same input map the file privately
+// (copy on write, so solvers may still mutate what they get) and use the sections in place.
+// A file is only used when its magic, format version, day layout version, ABI, input hash and
+// size and payload checksum all match, anything else is treated as a miss and rewritten.
+
+#define CACHE_FORMAT_VERSION 1
+#define CACHE_MAX_SECTIONS 16
+#define CACHE_ALIGNMENT 64
+#define CACHE_ENV "AOC_CACHE"
+#define CACHE_PATH_SIZE 4096
+
+typedef struct {
+    u64 name_hash;
+    u64 input_hash;
+    u64 input_size;
+    u32 version; // bumped by a day whenever its section layout changes
+} cache_key_t;
+
+typedef struct {
+    const void *data[CACHE_MAX_SECTIONS];
+    u64 sizes[CACHE_MAX_SECTIONS];
+    u32 count;
+    bool overflow;
+} cache_writer_t;
+
+typedef struct {
+    unsigned char *base;
+    usize size;
+    void *sections[CACHE_MAX_SECTIONS];
+    u64 sizes[CACHE_MAX_SECTIONS];
+    u32 count;
+} cache_view_t;
+
+u64 cache_hash(const void *data, usize size, u64 seed);
+const char *cache_dir(void);
+bool cache_path(char *buffer, usize size, const char *dir, const char *name, u64 input_hash);
+void cache_writer_add(cache_writer_t *writer, const void *data, u64 size);
+bool cache_save(const cache_writer_t *writer, const char *path, const cache_key_t *key);
+bool cache_open(cache_view_t *view, const char *path, const cache_key_t *key);
+void *cache_section(const cache_view_t *view, u32 index, u64 *size);
+void cache_close(cache_view_t *view);
+
+#ifdef CACHE_IMPLEMENTATION
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CACHE_HAS_MMAP 1
+#endif
+
+#define CACHE_MAGIC "AOCCACHE"
+
+typedef struct {
+    char magic[8];
+    u32 format_version;
+    u32 version;
+    u64 abi;
+    u64 name_hash;
+    u64 input_hash;
+    u64 input_size;
+    u64 file_size;
+    u64 checksum; // of everything after the header
+    u32 section_count;
+    u32 reserved;
+    u64 offsets[CACHE_MAX_SECTIONS];
+    u64 sizes[CACHE_MAX_SECTIONS];
+} cache_header_t;
+
+#define CACHE_HEADER_SIZE \
+    ((sizeof(cache_header_t) + CACHE_ALIGNMENT - 1) & ~(usize)(CACHE_ALIGNMENT - 1))
+
+// byte order, pointer width and the widest alignment, a cache only moves between equal hosts
+static u64 cache_abi(void)
+{
+    const u32 probe = 0x01020304;
+    u8 first = 0;
+    memcpy(&first, &probe, 1);
+
+    return (u64)first << 16 | (u64)sizeof(void *) << 8 | (u64)_Alignof(max_align_t);
+}
+
+static u64 cache_mix(u64 value)
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ull;
+    value ^= value >> 33;
+    return value;
+}
+
+// four independent lanes of eight bytes so the multiplies overlap, not cryptographic
+u64 cache_hash(const void *data, usize size, u64 seed)
+{
+    const unsigned char *bytes = data;
+    u64 lanes[4] = {
+        seed ^ 0x9e3779b97f4a7c15ull,
+        seed ^ 0xbf58476d1ce4e5b9ull,
+        seed ^ 0x94d049bb133111ebull,
+        seed ^ 0x2545f4914f6cdd1dull,
+    };
+    usize i = 0;
+
+    for (; i + 32 <= size; i += 32) {
+        for (usize lane = 0; lane < 4; ++lane) {
+            u64 word = 0;
+            memcpy(&word, bytes + i + lane * 8, sizeof(word));
+
+            lanes[lane] = (lanes[lane] ^ word) * 0xff51afd7ed558ccdull;
+            lanes[lane] ^= lanes[lane] >> 29;
+        }
+    }
+
+    u64 hash = (u64)size;
+
+    for (usize lane = 0; lane < 4; ++lane)
+        hash = cache_mix(hash ^ lanes[lane]);
+
+    for (; i < size; i += 8) {
+        u64 word = 0;
+        memcpy(&word, bytes + i, size - i < 8 ? size - i : 8);
+        hash = cache_mix(hash ^ word);
+    }
+
+    return hash;
+}
+
+const char *cache_dir(void)
+{
+    const char *dir = getenv(CACHE_ENV);
+    return dir && dir[0] != '\0' ? dir : NULL;
+}
+
+bool cache_path(char *buffer, usize size, const char *dir, const char *name, u64 input_hash)
+{
+    int written = snprintf(buffer, size, "%s/%s-%016llx.bin", dir, name,
+                           (unsigned long long)input_hash);
+
+    return written > 0 && (usize)written < size;
+}
+
+void cache_writer_add(cache_writer_t *writer, const void *data, u64 size)
+{
+    if (writer->count == CACHE_MAX_SECTIONS) {
+        writer->overflow = true;
+        return;
+    }
+
+    writer->data[writer->count] = data;
+    writer->sizes[writer->count] = size;
+    writer->count += 1;
+}
+
+#ifdef CACHE_HAS_MMAP
+
+static bool cache_write_all(int fd, const unsigned char *data, usize size)
+{
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+
+        data += written;
+        size -= (usize)written;
+    }
+
+    return true;
+}
+
+// the file is put together in memory and renamed into place, so readers never see half of it
+bool cache_save(const cache_writer_t *writer, const char *path, const cache_key_t *key)
+{
+    if (writer->overflow)
+        return false;
+
+    cache_header_t header = {
+        .format_version = CACHE_FORMAT_VERSION,
+        .version = key->version,
+        .abi = cache_abi(),
+        .name_hash = key->name_hash,
+        .input_hash = key->input_hash,
+        .input_size = key->input_size,
+        .section_count = writer->count,
+    };
+    memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+
+    u64 offset = CACHE_HEADER_SIZE;
+
+    for (u32 i = 0; i < writer->count; ++i) {
+        header.offsets[i] = offset;
+        header.sizes[i] = writer->sizes[i];
+        offset = (offset + writer->sizes[i] + CACHE_ALIGNMENT - 1) & ~(u64)(CACHE_ALIGNMENT - 1);
+    }
+
+    header.file_size = offset;
+
+    unsigned char *image = calloc(1, (usize)header.file_size);
+    if (!image)
+        return false;
+
+    for (u32 i = 0; i < writer->count; ++i) {
+        if (writer->sizes[i] > 0)
+            memcpy(image + header.offsets[i], writer->data[i], (usize)writer->sizes[i]);
+    }
+
+    header.checksum = cache_hash(image + CACHE_HEADER_SIZE,
+                                 (usize)(header.file_size - CACHE_HEADER_SIZE), key->input_hash);
+    memcpy(image, &header, sizeof(header));
+
+    // a missing directory is created, only the last path component though
+    const char *slash = strrchr(path, '/');
+    if (slash && slash != path) {
+        char dir[CACHE_PATH_SIZE];
+        usize len = (usize)(slash - path);
+
+        if (len < sizeof(dir)) {
+            memcpy(dir, path, len);
+            dir[len] = '\0';
+            mkdir(dir, 0755);
+        }
+    }
+
+    char tmp[CACHE_PATH_SIZE];
+    bool saved = false;
+
+    if (snprintf(tmp, sizeof(tmp), "%s.%ld.tmp", path, (long)getpid()) < (int)sizeof(tmp)) {
+        int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        if (fd != -1) {
+            saved = cache_write_all(fd, image, (usize)header.file_size);
+            saved = close(fd) == 0 && saved;
+            saved = saved && rename(tmp, path) == 0;
+
+            if (!saved)
+                unlink(tmp);
+        }
+    }
+
+    free(image);
+    return saved;
+}
+
+static bool cache_valid(const cache_view_t *view, const cache_key_t *key)
+{
+    if (view->size < CACHE_HEADER_SIZE)
+        return false;
+
+    cache_header_t header;
+    memcpy(&header, view->base, sizeof(header));
+
+    if (memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.format_version != CACHE_FORMAT_VERSION || header.version != key->version ||
+        header.abi != cache_abi() || header.name_hash != key->name_hash ||
+        header.input_hash != key->input_hash || header.input_size != key->input_size ||
+        header.file_size != view->size || header.section_count > CACHE_MAX_SECTIONS)
+        return false;
+
+    for (u32 i = 0; i < header.section_count; ++i) {
+        if (header.offsets[i] % CACHE_ALIGNMENT != 0 || header.offsets[i] > view->size ||
+            header.sizes[i] > view->size - header.offsets[i])
+            return false;
+    }
+
+    return cache_hash(view->base + CACHE_HEADER_SIZE, view->size - CACHE_HEADER_SIZE,
+                      key->input_hash) == header.checksum;
+}
+
+bool cache_open(cache_view_t *view, const char *path, const cache_key_t *key)
+{
+    *view = (cache_view_t){ 0 };
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+
+    void *base =
+        mmap(NULL, (usize)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED)
+        return false;
+
+    view->base = base;
+    view->size = (usize)st.st_size;
+
+    if (!cache_valid(view, key)) {
+        cache_close(view);
+        return false;
+    }
+
+    cache_header_t header;
+    memcpy(&header, view->base, sizeof(header));
+
+    view->count = header.section_count;
+
+    for (u32 i = 0; i < header.section_count; ++i) {
+        view->sections[i] = view->base + header.offsets[i];
+        view->sizes[i] = header.sizes[i];
+    }
+
+    return true;
+}
+
+void cache_close(cache_view_t *view)
+{
+    if (view->base)
+        munmap(view->base, view->size);
+
+    *view = (cache_view_t){ 0 };
+}
+
+#else
+
+bool cache_save(const cache_writer_t *writer, const char *path, const cache_key_t *key)
+{
+    (void)writer, (void)path, (void)key;
+    return false;
+}
+
+bool cache_open(cache_view_t *view, const char *path, const cache_key_t *key)
+{
+    (void)path, (void)key;
+    *view = (cache_view_t){ 0 };
+    return false;
+}
+
+void cache_close(cache_view_t *view)
+{
+    *view = (cache_view_t){ 0 };
+}
+
+#endif // CACHE_HAS_MMAP
+
+// NULL when the section is missing, size may be NULL when the caller knows it
+void *cache_section(const cache_view_t *view, u32 index, u64 *size)
+{
+    if (index >= view->count)
+        return NULL;
+
+    if (size)
+        *size = view->sizes[index];
+
+    return view->sections[index];
+}
+
+#endif // CACHE_IMPLEMENTATION
@@ -0,0 +1,287 @@
+#pragma once
+
+#include "type_defs.h"
+#include "arena.h"
+#include "cache.h"
+#include "file.h"
+#include "str.h"
+#include <stdbool.h>
+
+// every day describes itself with a day_t, its own main and the runner both drive it through
+// day_run so the phases are split and timed the same way everywhere
+typedef enum {
+    DAY_PHASE_READ,
+    DAY_PHASE_PARSE,
+    DAY_PHASE_PART1,
+    DAY_PHASE_PART2,
+    DAY_PHASE_COUNT,
+} day_phase_t;
+
+typedef struct {
+    const char *name;
+    const char *input; // default input, relative to the repository root
+    void *(*parse)(arena_t *arena, str_t source);
+    // optional, used instead of parse when reading a file so the input never has to be loaded
+    void *(*parse_stream)(arena_t *arena, line_reader_t *reader);
+    char stream_delim;
+    // files smaller than this still go through parse, 0 streams every file
+    u64 stream_min_size;
+    i64 (*part1)(void *context);
+    i64 (*part2)(void *context);
+    // optional, lets AOC_CACHE keep the parsed context on disk. cache_save adds the arrays the
+    // context is built from, flattening into the arena where needed, cache_load rebuilds the
+    // context on top of the mapped sections. Bump cache_version whenever the sections change
+    u32 cache_version;
+    bool (*cache_save)(arena_t *arena, void *context, cache_writer_t *writer);
+    void *(*cache_load)(arena_t *arena, const cache_view_t *view);
+} day_t;
+
+typedef struct {
+    i64 part1;
+    i64 part2;
+    u64 phase_ns[DAY_PHASE_COUNT];
+} day_result_t;
+
+#define DAY_ARENA_SIZE 1024
+// where days that parse in parallel and cache their context switch to a constant memory fold
+#ifndef DAY_STREAM_MIN_SIZE
+#define DAY_STREAM_MIN_SIZE (1ull << 30)
+#endif
+// inputs from this size on are parsed into one reserved range on huge pages, see
+// day_arena_create, reserving DAY_VIRTUAL_RESERVE_FACTOR times the input before chaining
+#ifndef DAY_VIRTUAL_MIN_SIZE
+#define DAY_VIRTUAL_MIN_SIZE (64ull << 20)
+#endif
+#define DAY_VIRTUAL_RESERVE_FACTOR 16
+
+// days are built into the runner as well, where their main is left out
+#ifdef AOC_RUNNER
+#define DAY_MAIN(day)
+#else
+#define DAY_MAIN(day)                        \
+    int main(int argc, char **argv)          \
+    {                                        \
+        return day_main(&(day), argc, argv); \
+    }
+#endif
+
+u64 day_now_ns(void);
+const char *day_phase_name(day_phase_t phase);
+bool day_run(const day_t *day, arena_t *arena, const char *filename, day_result_t *result);
+bool day_solve(const day_t *day, arena_t *arena, str_t source, day_result_t *result);
+bool day_arena_create(arena_t *arena, u64 input_size, usize capacity);
+int day_main(const day_t *day, int argc, char **argv);
+
+#ifdef DAY_IMPLEMENTATION
+
+#include <string.h>
+#include <time.h>
+
+#include "logger.h"
+
+u64 day_now_ns(void)
+{
+    struct timespec now = { 0 };
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000ull + (u64)now.tv_nsec;
+}
+
+const char *day_phase_name(day_phase_t phase)
+{
+    switch (phase) {
+    case DAY_PHASE_READ:
+        return "read";
+    case DAY_PHASE_PARSE:
+        return "parse";
+    case DAY_PHASE_PART1:
+        return "part1";
+    case DAY_PHASE_PART2:
+        return "part2";
+    default:
+        return "unknown";
+    }
+}
+
+static void day_solve_parts(const day_t *day, void *context, day_result_t *result)
+{
+    u64 start = day_now_ns();
+    result->part1 = day->part1(context);
+    u64 end = day_now_ns();
+    result->phase_ns[DAY_PHASE_PART1] = end - start;
+
+    start = end;
+    result->part2 = day->part2(context);
+    result->phase_ns[DAY_PHASE_PART2] = day_now_ns() - start;
+}
+
+static u64 day_cache_key(const day_t *day, str_t source, cache_key_t *key)
+{
+    *key = (cache_key_t){
+        .name_hash = cache_hash(day->name, strlen(day->name), 0),
+        .input_hash = cache_hash(source.data, source.len, 0),
+        .input_size = source.len,
+        .version = day->cache_version,
+    };
+
+    return key->input_hash;
+}
+
+// parse through the cache, the cache is only written before the parts get to mutate the context
+static void *day_parse_cached(const day_t *day, arena_t *arena, str_t source, const char *dir,
+                              cache_view_t *view)
+{
+    char path[CACHE_PATH_SIZE];
+    cache_key_t key;
+
+    if (!cache_path(path, sizeof(path), dir, day->name, day_cache_key(day, source, &key)))
+        return day->parse(arena, source);
+
+    if (cache_open(view, path, &key)) {
+        void *context = day->cache_load(arena, view);
+
+        if (context) {
+            LOG(LOG_DEBUG, "%s: cache hit for %016llx", day->name,
+                (unsigned long long)key.input_hash);
+            return context;
+        }
+
+        cache_close(view);
+    }
+
+    LOG(LOG_DEBUG, "%s: cache miss for %016llx", day->name, (unsigned long long)key.input_hash);
+
+    void *context = day->parse(arena, source);
+    cache_writer_t writer = { 0 };
+
+    if (context && (!day->cache_save(arena, context, &writer) || !cache_save(&writer, path, &key)))
+        LOG(LOG_WARN, "%s: failed to write the parse cache", day->name);
+
+    return context;
+}
+
+// parses and solves an input that is already in memory, the read phase is left untouched
+bool day_solve(const day_t *day, arena_t *arena, str_t source, day_result_t *result)
+{
+    const char *dir = day->cache_save && day->cache_load ? cache_dir() : NULL;
+    cache_view_t view = { 0 };
+
+    u64 start = day_now_ns();
+    void *context =
+        dir ? day_parse_cached(day, arena, source, dir, &view) : day->parse(arena, source);
+    result->phase_ns[DAY_PHASE_PARSE] = day_now_ns() - start;
+
+    if (!context) {
+        LOG(LOG_ERROR, "%s: failed to parse input", day->name);
+        return false;
+    }
+
+    day_solve_parts(day, context, result);
+    cache_close(&view);
+    return true;
+}
+
+static bool day_run_stream(const day_t *day, arena_t *arena, const char *filename,
+                           day_result_t *result)
+{
+    line_reader_t reader = { 0 };
+
+    u64 start = day_now_ns();
+    bool opened = line_reader_open(&reader, arena, filename, day->stream_delim,
+                                   LINE_READER_BUFFER_SIZE);
+    u64 end = day_now_ns();
+    result->phase_ns[DAY_PHASE_READ] = end - start;
+
+    if (!opened) {
+        LOG(LOG_ERROR, "%s: failed to read file '%s'", day->name, filename);
+        return false;
+    }
+
+    // reading and parsing are interleaved here, the refills are counted as parse time
+    start = end;
+    void *context = day->parse_stream(arena, &reader);
+    line_reader_close(&reader);
+    result->phase_ns[DAY_PHASE_PARSE] = day_now_ns() - start;
+
+    // a failed refill ends the records early, whatever was parsed up to there is incomplete
+    if (reader.error) {
+        LOG(LOG_ERROR, "%s: failed to read file '%s'", day->name, filename);
+        return false;
+    }
+
+    if (!context) {
+        LOG(LOG_ERROR, "%s: failed to parse input", day->name);
+        return false;
+    }
+
+    day_solve_parts(day, context, result);
+    return true;
+}
+
+bool day_run(const day_t *day, arena_t *arena, const char *filename, day_result_t *result)
+{
+    u64 size = 0;
+
+    if (day->parse_stream && (day->stream_min_size == 0 ||
+                              (input_size(filename, &size) && size >= day->stream_min_size)))
+        return day_run_stream(day, arena, filename, result);
+
+    input_view_t input = { 0 };
+
+    u64 start = day_now_ns();
+    bool mapped = map_input(arena, filename, &input);
+    result->phase_ns[DAY_PHASE_READ] = day_now_ns() - start;
+
+    if (!mapped) {
+        LOG(LOG_ERROR, "%s: failed to read file '%s'", day->name, filename);
+        return false;
+    }
+
+    str_t source = { .data = input.data, .len = input.size };
+    bool solved = day_solve(day, arena, source, result);
+
+    unmap_input(&input);
+    return solved;
+}
+
+// small inputs get a malloc chain starting at capacity. Large ones get a single contiguous
+// reservation committed on demand on huge pages, which keeps the parsed arrays in one range
+// for the prefetchers and the TLB. The chain is the fallback when the reservation fails
+bool day_arena_create(arena_t *arena, u64 input_size, usize capacity)
+{
+    if (input_size >= DAY_VIRTUAL_MIN_SIZE &&
+        input_size <= SIZE_MAX / DAY_VIRTUAL_RESERVE_FACTOR &&
+        arena_create_virtual(arena, (usize)input_size * DAY_VIRTUAL_RESERVE_FACTOR,
+                             ARENA_HUGE_PAGES))
+        return true;
+
+    return arena_create(arena, capacity);
+}
+
+int day_main(const day_t *day, int argc, char **argv)
+{
+    const char *filename = argc > 1 ? argv[1] : day->input;
+
+    arena_t arena = { 0 };
+    u64 size = 0;
+    input_size(filename, &size); // stays 0 for standard input and pipes
+
+    if (!day_arena_create(&arena, size, DAY_ARENA_SIZE)) {
+        LOG(LOG_ERROR, "%s", "Failed to create arena");
+        return 1;
+    }
+
+    day_result_t result = { 0 };
+    bool solved = day_run(day, &arena, filename, &result);
+
+    if (solved) {
+        printf("Part 1: %lld\n", (long long)result.part1);
+        printf("Part 2: %lld\n", (long long)result.part2);
+    }
+
+    arena_stats_dump(&arena, stderr);
+    arena_destroy(&arena);
+
+    return solved ? 0 : 1;
+}
+
+#endif // DAY_IMPLEMENTATION
@@ -1,16 +1,111 @@
 #pragma once
 
 #include "arena.h"
+#include "timer.h"
 
+typedef struct {
+    const char *data; // always NUL-terminated at data[size]
+    usize size;
+    usize mapped; // length of the file mapping, 0 when data was copied into the arena
+} input_view_t;
+
+typedef struct {
+    int fd;
+    char delim;
+    char *buffer; // capacity + 1 bytes so the last record can always be terminated
+    usize capacity;
+    usize start;
+    usize end;
+    bool eof;
+    bool error; // a failed read or grow, next then stops as if at EOF so check this after
+    arena_t *arena;
+} line_reader_t;
+
+#define LINE_READER_BUFFER_SIZE (64 * 1024)
+#define INPUT_READ_CHUNK (64 * 1024)
+
+// "-" reads standard input, pipes and other unseekable files are read until EOF
 char *get_input(arena_t *a, const char *filename);
+char *get_input_fd(arena_t *a, int fd, usize *size);
+bool map_input(arena_t *a, const char *filename, input_view_t *view);
+void unmap_input(input_view_t *view);
+bool input_size(const char *filename, u64 *size);
+bool line_reader_open(line_reader_t *reader, arena_t *a, const char *filename, char delim,
+                      usize buffer_size);
+bool line_reader_next(line_reader_t *reader, char **record, usize *len);
+void line_reader_close(line_reader_t *reader);
 
 #ifdef FILE_IMPLEMENTATION
 
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 
-char *get_input(arena_t *a, const char *filename)
+#if defined(__unix__) || defined(__APPLE__)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define FILE_HAS_POSIX 1
+#endif
+
+#ifdef FILE_HAS_POSIX
+
+char *get_input_fd(arena_t *a, int fd, usize *size)
+{
+    usize capacity = INPUT_READ_CHUNK;
+    usize len = 0;
+
+    char *input = arena_alloc(a, capacity + 1);
+    if (!input)
+        return NULL;
+
+    for (;;) {
+        // the buffer is the newest allocation, so arena_realloc grows it in place when it can
+        if (len == capacity) {
+            char *grown = arena_realloc(a, input, capacity + 1, capacity * 2 + 1);
+            if (!grown)
+                return NULL;
+
+            input = grown;
+            capacity *= 2;
+        }
+
+        isize bytes_read = read(fd, input + len, capacity - len);
+
+        if (bytes_read == -1) {
+            if (errno == EINTR)
+                continue;
+
+            perror("read failed");
+            return NULL;
+        }
+
+        if (bytes_read == 0)
+            break;
+
+        len += (usize)bytes_read;
+    }
+
+    input = arena_realloc(a, input, capacity + 1, len + 1);
+    input[len] = '\0';
+
+    if (size)
+        *size = len;
+
+    return input;
+}
+
+#endif // FILE_HAS_POSIX
+
+static char *read_input(arena_t *a, const char *filename)
 {
+#ifdef FILE_HAS_POSIX
+    if (strcmp(filename, "-") == 0)
+        return get_input_fd(a, STDIN_FILENO, NULL);
+#endif
+
     FILE *file_ptr = fopen(filename, "r");
 
     if (!file_ptr) {
@@ -19,6 +114,10 @@ char *get_input(arena_t *a, const char *filename)
     }
 
     if (fseek(file_ptr, 0, SEEK_END) == -1) {
+#ifdef FILE_HAS_POSIX
+        if (errno == ESPIPE)
+            goto stream;
+#endif
         perror("fseek failed");
         goto cleanup;
     }
@@ -35,8 +134,16 @@ char *get_input(arena_t *a, const char *filename)
         goto cleanup;
     }
 
-    assert(size > 0);
+#ifdef FILE_HAS_POSIX
+    // character devices and procfs-like files report a size of zero
+    if (size == 0)
+        goto stream;
+#endif
+
     char *input = arena_alloc(a, (usize)size + 1);
+    if (!input)
+        goto cleanup;
+
     usize bytes_read = fread(input, sizeof(char), (unsigned long)size, file_ptr);
     input[bytes_read] = '\0';
 
@@ -49,9 +156,245 @@ char *get_input(arena_t *a, const char *filename)
 
     return input;
 
+#ifdef FILE_HAS_POSIX
+stream:
+    input = get_input_fd(a, fileno(file_ptr), NULL);
+    fclose(file_ptr);
+
+    return input;
+#endif
+
 cleanup:
     fclose(file_ptr);
     return NULL;
 }
 
+char *get_input(arena_t *a, const char *filename)
+{
+    TIMER_SCOPE("read");
+
+    return read_input(a, filename);
+}
+
+// the caller is already timed, so this goes through read_input directly
+static bool map_input_copy(arena_t *a, const char *filename, input_view_t *view)
+{
+    char *input = read_input(a, filename);
+    if (!input)
+        return false;
+
+    view->data = input;
+    view->size = strlen(input);
+    view->mapped = 0;
+    return true;
+}
+
+bool map_input(arena_t *a, const char *filename, input_view_t *view)
+{
+    TIMER_SCOPE("read");
+
+#ifdef FILE_HAS_POSIX
+    if (strcmp(filename, "-") == 0)
+        return map_input_copy(a, filename, view);
+
+    int fd = open(filename, O_RDONLY);
+
+    if (fd == -1) {
+        perror("open failed");
+        return false;
+    }
+
+    struct stat st = { 0 };
+
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+        close(fd);
+        return map_input_copy(a, filename, view);
+    }
+
+    usize size = (usize)st.st_size;
+    usize page = (usize)sysconf(_SC_PAGESIZE);
+    usize mapped = (size + 1 + page - 1) / page * page;
+
+    // reserve one byte past the file so the view stays NUL-terminated even when the file
+    // ends on a page boundary, then map the file over the front of the reservation
+    void *region = mmap(NULL, mapped, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        close(fd);
+        return map_input_copy(a, filename, view);
+    }
+
+    int map_flags = MAP_PRIVATE | MAP_FIXED;
+#ifdef MAP_POPULATE
+    map_flags |= MAP_POPULATE;
+#endif
+
+    if (mmap(region, size, PROT_READ, map_flags, fd, 0) == MAP_FAILED) {
+        munmap(region, mapped);
+        close(fd);
+        return map_input_copy(a, filename, view);
+    }
+
+    close(fd);
+
+#ifdef MADV_SEQUENTIAL
+    madvise(region, size, MADV_SEQUENTIAL);
+#endif
+
+    view->data = region;
+    view->size = size;
+    view->mapped = mapped;
+    return true;
+#else
+    return map_input_copy(a, filename, view);
+#endif
+}
+
+void unmap_input(input_view_t *view)
+{
+    if (!view)
+        return;
+
+#ifdef FILE_HAS_POSIX
+    if (view->mapped > 0)
+        munmap((void *)view->data, view->mapped);
+#endif
+
+    view->data = NULL;
+    view->size = 0;
+    view->mapped = 0;
+}
+
+// regular files only, "-", pipes and anything else that has to be read to be sized fail
+bool input_size(const char *filename, u64 *size)
+{
+#ifdef FILE_HAS_POSIX
+    struct stat st = { 0 };
+
+    if (strcmp(filename, "-") == 0 || stat(filename, &st) == -1 || !S_ISREG(st.st_mode))
+        return false;
+
+    *size = (u64)st.st_size;
+    return true;
+#else
+    (void)filename, (void)size;
+    return false;
+#endif
+}
+
+#ifdef FILE_HAS_POSIX
+
+bool line_reader_open(line_reader_t *reader, arena_t *a, const char *filename, char delim,
+                      usize buffer_size)
+{
+    assert(buffer_size > 0);
+
+    reader->buffer = arena_alloc(a, buffer_size + 1);
+    if (!reader->buffer)
+        return false;
+
+    reader->fd = strcmp(filename, "-") == 0 ? STDIN_FILENO : open(filename, O_RDONLY);
+
+    if (reader->fd == -1) {
+        perror("open failed");
+        return false;
+    }
+
+    reader->delim = delim;
+    reader->capacity = buffer_size;
+    reader->start = 0;
+    reader->end = 0;
+    reader->eof = false;
+    reader->error = false;
+    reader->arena = a;
+    return true;
+}
+
+static bool line_reader_fill(line_reader_t *reader)
+{
+    TIMER_SCOPE("read");
+
+    if (reader->start > 0) {
+        memmove(reader->buffer, reader->buffer + reader->start, reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->start = 0;
+    }
+
+    // a single record longer than the whole buffer, the only case where memory grows
+    if (reader->end == reader->capacity) {
+        char *grown = arena_realloc(reader->arena, reader->buffer, reader->capacity + 1,
+                                    reader->capacity * 2 + 1);
+        if (!grown) {
+            reader->error = true;
+            return false;
+        }
+
+        reader->buffer = grown;
+        reader->capacity *= 2;
+    }
+
+    isize bytes_read = 0;
+
+    do {
+        bytes_read = read(reader->fd, reader->buffer + reader->end, reader->capacity - reader->end);
+    } while (bytes_read == -1 && errno == EINTR);
+
+    if (bytes_read == -1) {
+        perror("read failed");
+        reader->error = true;
+        return false;
+    }
+
+    if (bytes_read == 0)
+        reader->eof = true;
+
+    reader->end += (usize)bytes_read;
+    return true;
+}
+
+bool line_reader_next(line_reader_t *reader, char **record, usize *len)
+{
+    usize scanned = reader->start;
+
+    for (;;) {
+        char *found = memchr(reader->buffer + scanned, reader->delim, reader->end - scanned);
+
+        if (found) {
+            *record = reader->buffer + reader->start;
+            *len = (usize)(found - *record);
+            *found = '\0';
+            reader->start += *len + 1;
+            return true;
+        }
+
+        if (reader->eof)
+            break;
+
+        // the partial record is moved to the front of the buffer, only scan the new bytes
+        usize pending = reader->end - reader->start;
+        if (!line_reader_fill(reader))
+            return false;
+
+        scanned = pending;
+    }
+
+    if (reader->start == reader->end)
+        return false;
+
+    *record = reader->buffer + reader->start;
+    *len = reader->end - reader->start;
+    reader->buffer[reader->end] = '\0';
+    reader->start = reader->end;
+    return true;
+}
+
+void line_reader_close(line_reader_t *reader)
+{
+    if (reader->fd != -1 && reader->fd != STDIN_FILENO)
+        close(reader->fd);
+
+    reader->fd = -1;
+}
+
+#endif // FILE_HAS_POSIX
+
 #endif // FILE_IMPLEMENTATION
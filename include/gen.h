@@ -0,0 +1,126 @@
+#pragma once
+
+#include "type_defs.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+// synthetic inputs for benchmarking, every day has a gen.c writing an input shaped like the
+// checked-in one but scale times larger to stdout:
+//
+//     build/day005/gen [scale] [seed] > input.txt
+//
+// the same scale and seed always produce the same bytes, on every platform
+
+#define GEN_DEFAULT_SEED 2021
+
+typedef struct {
+    u64 state;
+} gen_rng_t;
+
+typedef bool (*gen_fn_t)(gen_rng_t *rng, u64 scale, FILE *out);
+
+// splitmix64, small and good enough for test data
+static inline u64 gen_next(gen_rng_t *rng)
+{
+    u64 z = (rng->state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// uniform in [0, bound), the biased tail of the range is rejected
+static inline u64 gen_below(gen_rng_t *rng, u64 bound)
+{
+    if (bound <= 1)
+        return 0;
+
+    u64 limit = UINT64_MAX - UINT64_MAX % bound;
+    u64 value = 0;
+
+    do {
+        value = gen_next(rng);
+    } while (value >= limit);
+
+    return value % bound;
+}
+
+// uniform in [min, max]
+static inline i64 gen_range(gen_rng_t *rng, i64 min, i64 max)
+{
+    return min + (i64)gen_below(rng, (u64)(max - min) + 1);
+}
+
+static inline void gen_shuffle_u32(gen_rng_t *rng, u32 *items, usize count)
+{
+    for (usize i = count; i > 1; --i) {
+        usize j = (usize)gen_below(rng, i);
+        u32 tmp = items[i - 1];
+        items[i - 1] = items[j];
+        items[j] = tmp;
+    }
+}
+
+static inline u64 gen_isqrt(u64 value)
+{
+    u64 root = 0;
+
+    while ((root + 1) * (root + 1) <= value)
+        ++root;
+
+    return root;
+}
+
+int gen_main(gen_fn_t generate, int argc, char **argv);
+
+#define GEN_MAIN(generate)                       \
+    int main(int argc, char **argv)              \
+    {                                            \
+        return gen_main((generate), argc, argv); \
+    }
+
+#ifdef GEN_IMPLEMENTATION
+
+#include <errno.h>
+#include <stdlib.h>
+
+#define GEN_BUFFER_SIZE (1 << 20)
+
+static bool gen_parse_u64(const char *arg, u64 *value)
+{
+    char *end = NULL;
+
+    errno = 0;
+    unsigned long long parsed = strtoull(arg, &end, 10);
+
+    if (errno != 0 || end == arg || *end != '\0')
+        return false;
+
+    *value = (u64)parsed;
+    return true;
+}
+
+int gen_main(gen_fn_t generate, int argc, char **argv)
+{
+    u64 scale = 1;
+    u64 seed = GEN_DEFAULT_SEED;
+
+    if (argc > 3 || (argc > 1 && (!gen_parse_u64(argv[1], &scale) || scale == 0)) ||
+        (argc > 2 && !gen_parse_u64(argv[2], &seed))) {
+        fprintf(stderr, "Usage: %s [scale] [seed]\n", argv[0]);
+        return 1;
+    }
+
+    static char buffer[GEN_BUFFER_SIZE];
+    setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+
+    gen_rng_t rng = { .state = seed };
+
+    if (!generate(&rng, scale, stdout) || fflush(stdout) != 0 || ferror(stdout)) {
+        fprintf(stderr, "%s: failed to write the input\n", argv[0]);
+        return 1;
+    }
+
+    return 0;
+}
+
+#endif // GEN_IMPLEMENTATION
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "type_defs.h"
+#include "arena.h"
+#include <stdbool.h>
+
+// open addressing with robin hood probing, keys and values live in parallel arrays so a
+// probe sequence only walks the distance and key arrays
+typedef struct {
+    arena_t *arena;
+    u64 *keys;
+    u64 *values;
+    u8 *dists; // probe distance + 1, 0 marks an empty slot
+    usize capacity;
+    usize size;
+} hashmap_t;
+
+#define HASHMAP_CAPACITY 64
+
+bool hashmap_init(hashmap_t *map, arena_t *arena, usize capacity);
+bool hashmap_reserve(hashmap_t *map, usize count);
+bool hashmap_put(hashmap_t *map, u64 key, u64 value);
+bool hashmap_put_bulk(hashmap_t *map, const u64 *keys, const u64 *values, usize count);
+u64 *hashmap_get(const hashmap_t *map, u64 key);
+bool hashmap_remove(hashmap_t *map, u64 key);
+void hashmap_clear(hashmap_t *map);
+
+#ifdef HASHMAP_IMPLEMENTATION
+
+#include <string.h>
+
+#define HASHMAP_MAX_DIST 255
+
+static u64 hashmap_hash(u64 key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccd;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53;
+    key ^= key >> 33;
+    return key;
+}
+
+// keeps the load factor at or below 7/8
+static usize hashmap_capacity_for(usize count)
+{
+    usize capacity = HASHMAP_CAPACITY;
+
+    while (capacity - capacity / 8 < count)
+        capacity *= 2;
+
+    return capacity;
+}
+
+static bool hashmap_alloc(hashmap_t *map, usize capacity)
+{
+    u64 *keys = arena_alloc(map->arena, capacity * sizeof(*keys));
+    u64 *values = arena_alloc(map->arena, capacity * sizeof(*values));
+    u8 *dists = arena_alloc(map->arena, capacity * sizeof(*dists));
+
+    if (!keys || !values || !dists)
+        return false;
+
+    memset(dists, 0, capacity * sizeof(*dists));
+
+    map->keys = keys;
+    map->values = values;
+    map->dists = dists;
+    map->capacity = capacity;
+    map->size = 0;
+    return true;
+}
+
+bool hashmap_init(hashmap_t *map, arena_t *arena, usize capacity)
+{
+    if (!map || !arena)
+        return false;
+
+    map->arena = arena;
+    return hashmap_alloc(map, hashmap_capacity_for(capacity));
+}
+
+static bool hashmap_grow(hashmap_t *map, usize capacity);
+
+static bool hashmap_insert(hashmap_t *map, u64 key, u64 value)
+{
+    usize mask = map->capacity - 1;
+    usize index = hashmap_hash(key) & mask;
+    u8 dist = 1;
+
+    for (;;) {
+        if (map->dists[index] == 0) {
+            map->keys[index] = key;
+            map->values[index] = value;
+            map->dists[index] = dist;
+            map->size += 1;
+            return true;
+        }
+
+        if (map->dists[index] == dist && map->keys[index] == key) {
+            map->values[index] = value;
+            return true;
+        }
+
+        // the resident is closer to its home slot, it gives way to the richer probe
+        if (map->dists[index] < dist) {
+            u64 resident_key = map->keys[index];
+            u64 resident_value = map->values[index];
+            u8 resident_dist = map->dists[index];
+
+            map->keys[index] = key;
+            map->values[index] = value;
+            map->dists[index] = dist;
+
+            key = resident_key;
+            value = resident_value;
+            dist = resident_dist;
+        }
+
+        // whichever entry is still in hand is not counted in size, rehash and place it again
+        if (dist == HASHMAP_MAX_DIST)
+            return hashmap_grow(map, map->capacity * 2) && hashmap_insert(map, key, value);
+
+        index = (index + 1) & mask;
+        dist += 1;
+    }
+}
+
+static bool hashmap_grow(hashmap_t *map, usize capacity)
+{
+    hashmap_t old = *map;
+
+    if (!hashmap_alloc(map, capacity)) {
+        *map = old;
+        return false;
+    }
+
+    for (usize i = 0; i < old.capacity; ++i) {
+        if (old.dists[i] != 0 && !hashmap_insert(map, old.keys[i], old.values[i]))
+            return false;
+    }
+
+    return true;
+}
+
+bool hashmap_reserve(hashmap_t *map, usize count)
+{
+    usize capacity = hashmap_capacity_for(count);
+    if (capacity <= map->capacity)
+        return true;
+
+    return hashmap_grow(map, capacity);
+}
+
+bool hashmap_put(hashmap_t *map, u64 key, u64 value)
+{
+    if (!hashmap_reserve(map, map->size + 1))
+        return false;
+
+    return hashmap_insert(map, key, value);
+}
+
+bool hashmap_put_bulk(hashmap_t *map, const u64 *keys, const u64 *values, usize count)
+{
+    if (!hashmap_reserve(map, map->size + count))
+        return false;
+
+    for (usize i = 0; i < count; ++i) {
+        if (!hashmap_insert(map, keys[i], values[i]))
+            return false;
+    }
+
+    return true;
+}
+
+static isize hashmap_find(const hashmap_t *map, u64 key)
+{
+    usize mask = map->capacity - 1;
+    usize index = hashmap_hash(key) & mask;
+
+    for (usize dist = 1; map->dists[index] >= dist; ++dist) {
+        if (map->dists[index] == dist && map->keys[index] == key)
+            return (isize)index;
+
+        index = (index + 1) & mask;
+    }
+
+    return -1;
+}
+
+u64 *hashmap_get(const hashmap_t *map, u64 key)
+{
+    isize index = hashmap_find(map, key);
+    return index < 0 ? NULL : &map->values[index];
+}
+
+// backward shift deletion, so no tombstones are ever left in the table
+bool hashmap_remove(hashmap_t *map, u64 key)
+{
+    isize found = hashmap_find(map, key);
+    if (found < 0)
+        return false;
+
+    usize mask = map->capacity - 1;
+    usize index = (usize)found;
+    usize next = (index + 1) & mask;
+
+    while (map->dists[next] > 1) {
+        map->keys[index] = map->keys[next];
+        map->values[index] = map->values[next];
+        map->dists[index] = map->dists[next] - 1;
+
+        index = next;
+        next = (next + 1) & mask;
+    }
+
+    map->dists[index] = 0;
+    map->size -= 1;
+    return true;
+}
+
+void hashmap_clear(hashmap_t *map)
+{
+    memset(map->dists, 0, map->capacity * sizeof(*map->dists));
+    map->size = 0;
+}
+
+#endif // HASHMAP_IMPLEMENTATION
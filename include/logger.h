@@ -1,29 +1,504 @@
 #pragma once
 
+#include "type_defs.h"
 #include <stdio.h>
 
-typedef enum {
-    LOG_DEBUG,
-    LOG_INFO,
-    LOG_WARN,
-    LOG_ERROR,
-} log_level_t;
+// plain integers so LOG_LEVEL can be compared by the preprocessor
+#define LOG_DEBUG 0
+#define LOG_INFO 1
+#define LOG_WARN 2
+#define LOG_ERROR 3
+
+typedef int log_level_t;
 
 #ifndef LOG_LEVEL
 #define LOG_LEVEL LOG_INFO
 #endif
 
-static inline const char *log_level_str(log_level_t level);
+#define LOG_MAX_ARGS 12 // LOG_COUNT and LOG_MAP below go up to the same number
+#define LOG_RING_CAPACITY 1024 // records, must be a power of two
+#define LOG_DRAIN_INTERVAL_NS 1000000
+#define LOG_LINE_SIZE 512
+#define LOG_OUTPUT_BUFFER_SIZE (64 * 1024)
+
+void log_write(log_level_t level, const char *file, const char *func, int line, const char *fmt,
+               usize arg_count, const u64 *args);
+void log_flush(void);
+const char *log_level_str(log_level_t level);
+
+// arguments are captured as 64 bit words and only formatted on the drain side, pointers passed
+// for %s or %p have to outlive the call (string literals and argv are fine)
+static inline u64 log_arg_int(u64 value)
+{
+    return value;
+}
+
+static inline u64 log_arg_f64(double value)
+{
+    union {
+        double f;
+        u64 u;
+    } bits = { .f = value };
+
+    return bits.u;
+}
+
+static inline u64 log_arg_ptr(const void *value)
+{
+    return (u64)(uptr)value;
+}
+
+#define LOG_ARG(x)                                                                         \
+    _Generic((x),                                                                          \
+        float: log_arg_f64,                                                                \
+        double: log_arg_f64,                                                               \
+        char *: log_arg_ptr,                                                               \
+        const char *: log_arg_ptr,                                                         \
+        void *: log_arg_ptr,                                                               \
+        const void *: log_arg_ptr,                                                         \
+        default: log_arg_int)(x)
+
+#define LOG_COUNT(...) LOG_COUNT_(__VA_ARGS__, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_COUNT_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, n, ...) n
+
+#define LOG_CAT(a, b) LOG_CAT_(a, b)
+#define LOG_CAT_(a, b) a##b
 
-#define LOG(level, fmt, ...)                                                                      \
-    do {                                                                                          \
-        if (level >= LOG_LEVEL) {                                                                 \
-            fprintf(stderr, "%s %s::%s::%d: " fmt "\n", log_level_str(level), __FILE__, __func__, \
-                    __LINE__, __VA_ARGS__);                                                       \
-        }                                                                                         \
+#define LOG_MAP(m, ...) LOG_CAT(LOG_MAP_, LOG_COUNT(__VA_ARGS__))(m, __VA_ARGS__)
+#define LOG_MAP_1(m, a) m(a)
+#define LOG_MAP_2(m, a, ...) m(a), LOG_MAP_1(m, __VA_ARGS__)
+#define LOG_MAP_3(m, a, ...) m(a), LOG_MAP_2(m, __VA_ARGS__)
+#define LOG_MAP_4(m, a, ...) m(a), LOG_MAP_3(m, __VA_ARGS__)
+#define LOG_MAP_5(m, a, ...) m(a), LOG_MAP_4(m, __VA_ARGS__)
+#define LOG_MAP_6(m, a, ...) m(a), LOG_MAP_5(m, __VA_ARGS__)
+#define LOG_MAP_7(m, a, ...) m(a), LOG_MAP_6(m, __VA_ARGS__)
+#define LOG_MAP_8(m, a, ...) m(a), LOG_MAP_7(m, __VA_ARGS__)
+#define LOG_MAP_9(m, a, ...) m(a), LOG_MAP_8(m, __VA_ARGS__)
+#define LOG_MAP_10(m, a, ...) m(a), LOG_MAP_9(m, __VA_ARGS__)
+#define LOG_MAP_11(m, a, ...) m(a), LOG_MAP_10(m, __VA_ARGS__)
+#define LOG_MAP_12(m, a, ...) m(a), LOG_MAP_11(m, __VA_ARGS__)
+
+#define LOG_RECORD(level, fmt, ...)                                                          \
+    log_write((level), __FILE__, __func__, __LINE__, "" fmt, LOG_COUNT(__VA_ARGS__),         \
+              (const u64[]){ LOG_MAP(LOG_ARG, __VA_ARGS__) })
+
+// levels below LOG_LEVEL never reach the ring, the dead branch keeps the arguments type checked
+#define LOG_ELIDED(level, fmt, ...)              \
+    do {                                         \
+        if (0)                                   \
+            LOG_RECORD(level, fmt, __VA_ARGS__); \
     } while (0)
 
-static inline const char *log_level_str(log_level_t level)
+#if LOG_LEVEL <= LOG_DEBUG
+#define LOG_AT_LOG_DEBUG(fmt, ...) LOG_RECORD(LOG_DEBUG, fmt, __VA_ARGS__)
+#else
+#define LOG_AT_LOG_DEBUG(fmt, ...) LOG_ELIDED(LOG_DEBUG, fmt, __VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_INFO
+#define LOG_AT_LOG_INFO(fmt, ...) LOG_RECORD(LOG_INFO, fmt, __VA_ARGS__)
+#else
+#define LOG_AT_LOG_INFO(fmt, ...) LOG_ELIDED(LOG_INFO, fmt, __VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_WARN
+#define LOG_AT_LOG_WARN(fmt, ...) LOG_RECORD(LOG_WARN, fmt, __VA_ARGS__)
+#else
+#define LOG_AT_LOG_WARN(fmt, ...) LOG_ELIDED(LOG_WARN, fmt, __VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_ERROR
+#define LOG_AT_LOG_ERROR(fmt, ...) LOG_RECORD(LOG_ERROR, fmt, __VA_ARGS__)
+#else
+#define LOG_AT_LOG_ERROR(fmt, ...) LOG_ELIDED(LOG_ERROR, fmt, __VA_ARGS__)
+#endif
+
+// level has to be one of the LOG_* names, it is pasted rather than evaluated
+#define LOG(level, fmt, ...) LOG_AT_##level(fmt, __VA_ARGS__)
+
+#ifdef LOGGER_IMPLEMENTATION
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// one slot of the bounded multi producer ring, sequence says whose turn the slot is: equal to
+// the claim position when free, position + 1 once the record is published
+typedef struct {
+    atomic_size_t sequence;
+    u64 timestamp;
+    const char *fmt;
+    const char *file;
+    const char *func;
+    int line;
+    log_level_t level;
+    usize arg_count;
+    u64 args[LOG_MAX_ARGS];
+} log_record_t;
+
+static log_record_t log_records[LOG_RING_CAPACITY];
+static atomic_size_t log_head;
+static atomic_size_t log_tail;
+static atomic_flag log_draining = ATOMIC_FLAG_INIT;
+static atomic_bool log_stop;
+static pthread_once_t log_once = PTHREAD_ONCE_INIT;
+static pthread_t log_thread;
+static bool log_has_thread;
+static u64 log_start;
+static char log_output[LOG_OUTPUT_BUFFER_SIZE];
+static usize log_output_len;
+
+static u64 log_now(void)
+{
+    struct timespec now = { 0 };
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000ull + (u64)now.tv_nsec;
+}
+
+static usize log_appendf(char *buffer, usize size, usize len, const char *fmt, ...)
+{
+    if (len + 1 >= size)
+        return len;
+
+    va_list args;
+    va_start(args, fmt);
+    int written = vsnprintf(buffer + len, size - len, fmt, args);
+    va_end(args);
+
+    if (written < 0)
+        return len;
+
+    return len + (usize)written < size ? len + (usize)written : size - 1;
+}
+
+static long long log_signed(u64 value, int length)
+{
+    switch (length) {
+    case -2:
+        return (signed char)value;
+    case -1:
+        return (short)value;
+    case 0:
+        return (int)value;
+    case 1:
+        return (long)value;
+    default:
+        return (long long)value;
+    }
+}
+
+static unsigned long long log_unsigned(u64 value, int length)
+{
+    switch (length) {
+    case -2:
+        return (unsigned char)value;
+    case -1:
+        return (unsigned short)value;
+    case 0:
+        return (unsigned int)value;
+    case 1:
+        return (unsigned long)value;
+    default:
+        return (unsigned long long)value;
+    }
+}
+
+// walks the printf format once, every conversion is rebuilt as its own spec with the length
+// modifier normalised to ll so the captured 64 bit word can be handed to snprintf directly
+static usize log_format_args(char *buffer, usize size, usize len, const log_record_t *record)
+{
+    const char *fmt = record->fmt;
+    usize next_arg = 0;
+
+#define LOG_NEXT_ARG() (next_arg < record->arg_count ? record->args[next_arg++] : 0)
+#define LOG_SPEC_PUSH(c)                     \
+    do {                                     \
+        if (spec_len + 1 < sizeof(spec) - 3) \
+            spec[spec_len++] = (c);          \
+    } while (0)
+
+    while (*fmt) {
+        if (*fmt != '%') {
+            const char *end = strchr(fmt, '%');
+            usize run = end ? (usize)(end - fmt) : strlen(fmt);
+            len = log_appendf(buffer, size, len, "%.*s", (int)run, fmt);
+            fmt += run;
+            continue;
+        }
+
+        if (fmt[1] == '%') {
+            len = log_appendf(buffer, size, len, "%%");
+            fmt += 2;
+            continue;
+        }
+
+        char spec[48];
+        usize spec_len = 0;
+        spec[spec_len++] = *fmt++;
+
+        while (*fmt && strchr("-+ #0", *fmt))
+            LOG_SPEC_PUSH(*fmt++);
+
+        if (*fmt == '*') {
+            int width = (int)log_signed(LOG_NEXT_ARG(), 0);
+            spec_len = log_appendf(spec, sizeof(spec) - 3, spec_len, "%d", width);
+            fmt++;
+        } else {
+            while (*fmt >= '0' && *fmt <= '9')
+                LOG_SPEC_PUSH(*fmt++);
+        }
+
+        if (*fmt == '.') {
+            fmt++;
+            if (*fmt == '*') {
+                int precision = (int)log_signed(LOG_NEXT_ARG(), 0);
+                if (precision >= 0)
+                    spec_len = log_appendf(spec, sizeof(spec) - 3, spec_len, ".%d", precision);
+                fmt++;
+            } else {
+                LOG_SPEC_PUSH('.');
+                while (*fmt >= '0' && *fmt <= '9')
+                    LOG_SPEC_PUSH(*fmt++);
+            }
+        }
+
+        int length = 0;
+        while (*fmt && strchr("hljztL", *fmt)) {
+            if (*fmt == 'h')
+                length -= 1;
+            else if (*fmt == 'l')
+                length += 1;
+            else if (*fmt != 'L')
+                length = 2;
+            fmt++;
+        }
+
+        char conversion = *fmt;
+        if (!conversion)
+            break;
+        fmt++;
+
+        switch (conversion) {
+        case 'd':
+        case 'i':
+            spec[spec_len++] = 'l';
+            spec[spec_len++] = 'l';
+            spec[spec_len++] = conversion;
+            spec[spec_len] = '\0';
+            len = log_appendf(buffer, size, len, spec, log_signed(LOG_NEXT_ARG(), length));
+            break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            spec[spec_len++] = 'l';
+            spec[spec_len++] = 'l';
+            spec[spec_len++] = conversion;
+            spec[spec_len] = '\0';
+            len = log_appendf(buffer, size, len, spec, log_unsigned(LOG_NEXT_ARG(), length));
+            break;
+        case 'c':
+            spec[spec_len++] = conversion;
+            spec[spec_len] = '\0';
+            len = log_appendf(buffer, size, len, spec, (int)LOG_NEXT_ARG());
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A': {
+            union {
+                u64 u;
+                double f;
+            } bits = { .u = LOG_NEXT_ARG() };
+
+            spec[spec_len++] = conversion;
+            spec[spec_len] = '\0';
+            len = log_appendf(buffer, size, len, spec, bits.f);
+            break;
+        }
+        case 's': {
+            const char *str = (const char *)(uptr)LOG_NEXT_ARG();
+
+            spec[spec_len++] = conversion;
+            spec[spec_len] = '\0';
+            len = log_appendf(buffer, size, len, spec, str ? str : "(null)");
+            break;
+        }
+        case 'p':
+            spec[spec_len++] = conversion;
+            spec[spec_len] = '\0';
+            len = log_appendf(buffer, size, len, spec, (void *)(uptr)LOG_NEXT_ARG());
+            break;
+        default:
+            len = log_appendf(buffer, size, len, "%.*s%c", (int)spec_len, spec, conversion);
+            break;
+        }
+    }
+
+#undef LOG_NEXT_ARG
+#undef LOG_SPEC_PUSH
+
+    return len;
+}
+
+static void log_output_flush(void)
+{
+    if (log_output_len == 0)
+        return;
+
+    fwrite(log_output, 1, log_output_len, stderr);
+    fflush(stderr);
+    log_output_len = 0;
+}
+
+static void log_format_record(const log_record_t *record)
+{
+    char line[LOG_LINE_SIZE];
+    u64 elapsed = record->timestamp - log_start;
+    usize len = 0;
+
+    // one byte is kept back for the newline
+    len = log_appendf(line, sizeof(line) - 1, len, "[%llu.%06llu] %s %s::%s::%d: ",
+                      (unsigned long long)(elapsed / 1000000000ull),
+                      (unsigned long long)(elapsed % 1000000000ull / 1000ull),
+                      log_level_str(record->level), record->file, record->func, record->line);
+    len = log_format_args(line, sizeof(line) - 1, len, record);
+    line[len++] = '\n';
+
+    if (log_output_len + len > sizeof(log_output))
+        log_output_flush();
+
+    memcpy(log_output + log_output_len, line, len);
+    log_output_len += len;
+}
+
+// single consumer, whoever wins the flag drains every published record and writes them out
+// in one go, returns false when another thread is already draining
+static bool log_drain(void)
+{
+    if (atomic_flag_test_and_set_explicit(&log_draining, memory_order_acquire))
+        return false;
+
+    usize tail = atomic_load_explicit(&log_tail, memory_order_relaxed);
+
+    for (;;) {
+        log_record_t *record = &log_records[tail & (LOG_RING_CAPACITY - 1)];
+        if (atomic_load_explicit(&record->sequence, memory_order_acquire) != tail + 1)
+            break;
+
+        log_format_record(record);
+        atomic_store_explicit(&record->sequence, tail + LOG_RING_CAPACITY, memory_order_release);
+        tail += 1;
+    }
+
+    atomic_store_explicit(&log_tail, tail, memory_order_relaxed);
+    log_output_flush();
+    atomic_flag_clear_explicit(&log_draining, memory_order_release);
+    return true;
+}
+
+static void *log_drain_thread(void *arg)
+{
+    (void)arg;
+    struct timespec interval = { .tv_sec = 0, .tv_nsec = LOG_DRAIN_INTERVAL_NS };
+
+    while (!atomic_load_explicit(&log_stop, memory_order_acquire)) {
+        log_drain();
+        nanosleep(&interval, NULL);
+    }
+
+    return NULL;
+}
+
+static void log_shutdown(void)
+{
+    atomic_store_explicit(&log_stop, true, memory_order_release);
+
+    if (log_has_thread)
+        pthread_join(log_thread, NULL);
+
+    log_flush();
+}
+
+static void log_init(void)
+{
+    for (usize i = 0; i < LOG_RING_CAPACITY; ++i)
+        atomic_init(&log_records[i].sequence, i);
+
+    log_start = log_now();
+
+    // without a drain thread records still go out when the ring fills up, on errors and at exit
+    log_has_thread = pthread_create(&log_thread, NULL, log_drain_thread, NULL) == 0;
+    atexit(log_shutdown);
+}
+
+void log_write(log_level_t level, const char *file, const char *func, int line, const char *fmt,
+               usize arg_count, const u64 *args)
+{
+    pthread_once(&log_once, log_init);
+
+    u64 timestamp = log_now();
+    usize pos = atomic_load_explicit(&log_head, memory_order_relaxed);
+    log_record_t *record = NULL;
+
+    for (;;) {
+        record = &log_records[pos & (LOG_RING_CAPACITY - 1)];
+        usize sequence = atomic_load_explicit(&record->sequence, memory_order_acquire);
+        isize diff = (isize)(sequence - pos);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&log_head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            // the ring is full, help drain it rather than dropping the record
+            if (!log_drain())
+                sched_yield();
+            pos = atomic_load_explicit(&log_head, memory_order_relaxed);
+        } else {
+            pos = atomic_load_explicit(&log_head, memory_order_relaxed);
+        }
+    }
+
+    if (arg_count > LOG_MAX_ARGS)
+        arg_count = LOG_MAX_ARGS;
+
+    record->timestamp = timestamp;
+    record->fmt = fmt;
+    record->file = file;
+    record->func = func;
+    record->line = line;
+    record->level = level;
+    record->arg_count = arg_count;
+    memcpy(record->args, args, arg_count * sizeof(*args));
+    atomic_store_explicit(&record->sequence, pos + 1, memory_order_release);
+
+    // errors usually precede an early exit or a crash, get them out straight away
+    if (level >= LOG_ERROR)
+        log_flush();
+}
+
+// blocks until every record claimed before the call has been written
+void log_flush(void)
+{
+    usize head = atomic_load_explicit(&log_head, memory_order_acquire);
+
+    while (atomic_load_explicit(&log_tail, memory_order_relaxed) < head) {
+        if (!log_drain())
+            sched_yield();
+    }
+}
+
+const char *log_level_str(log_level_t level)
 {
     switch (level) {
     case LOG_DEBUG:
@@ -38,3 +513,5 @@ static inline const char *log_level_str(log_level_t level)
         return "UNKNOWN";
     }
 }
+
+#endif // LOGGER_IMPLEMENTATION
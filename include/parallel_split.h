@@ -0,0 +1,178 @@
+#pragma once
+
+#include "type_defs.h"
+#include "arena.h"
+#include "str.h"
+#include "thread_pool.h"
+#include "utils.h"
+#include <stdbool.h>
+
+// parses a large input on every core while keeping the records in input order
+//
+//     i64 *items = parallel_split(pool, arena, source, '\n', sizeof(i64), parse_chunk, NULL, &n);
+//
+// the source is cut into ranges that each end right after a delim, so no record straddles two
+// ranges. Every range is handed to fn which parses it into an array allocated from the arena of
+// the worker running it, the segments are then copied in range order into one array allocated
+// from the caller's arena and the worker arenas are dropped. Small inputs end up as a single
+// range parsed on the calling thread.
+
+#ifndef PARALLEL_SPLIT_MIN_CHUNK
+#define PARALLEL_SPLIT_MIN_CHUNK (256 * 1024)
+#endif
+
+#define PARALLEL_SPLIT_CHUNKS_PER_WORKER 4 // more ranges than workers so stealing can balance
+#define PARALLEL_SPLIT_ARENA_SIZE (64 * 1024)
+#define PARALLEL_SPLIT_MAX_RANGES (THREAD_POOL_MAX_THREADS * PARALLEL_SPLIT_CHUNKS_PER_WORKER)
+
+typedef struct {
+    void *items;
+    usize count;
+} parallel_segment_t;
+
+// items go into arena, scratch is rewound once the chunk is done
+typedef bool (*parallel_split_fn_t)(void *context, arena_t *arena, arena_t *scratch, str_t chunk,
+                                    parallel_segment_t *segment);
+
+usize parallel_split_ranges(str_t source, char delim, str_t *ranges, usize max_ranges,
+                            usize min_size);
+void *parallel_split(thread_pool_t *pool, arena_t *arena, str_t source, char delim,
+                     usize item_size, parallel_split_fn_t fn, void *context, usize *count);
+
+#ifdef PARALLEL_SPLIT_IMPLEMENTATION
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    parallel_split_fn_t fn;
+    void *context;
+    usize item_size;
+    unsigned char *items;
+    atomic_bool failed;
+    str_t ranges[PARALLEL_SPLIT_MAX_RANGES];
+    parallel_segment_t segments[PARALLEL_SPLIT_MAX_RANGES];
+    usize offsets[PARALLEL_SPLIT_MAX_RANGES];
+    arena_t arenas[THREAD_POOL_MAX_THREADS]; // one per worker, created on first use
+} parallel_split_job_t;
+
+usize parallel_split_ranges(str_t source, char delim, str_t *ranges, usize max_ranges,
+                            usize min_size)
+{
+    if (max_ranges == 0 || source.len == 0)
+        return 0;
+
+    usize wanted = source.len / (min_size ? min_size : 1);
+    wanted = wanted < 1 ? 1 : wanted > max_ranges ? max_ranges : wanted;
+
+    usize count = 0;
+    usize start = 0;
+
+    for (usize i = 1; i <= wanted && start < source.len; ++i) {
+        usize end = source.len;
+
+        // every cut but the last moves forward to just past the next delimiter
+        if (i < wanted) {
+            usize target = MAX(start, source.len / wanted * i);
+            const char *found = memchr(source.data + target, delim, source.len - target);
+            end = found ? (usize)(found - source.data) + 1 : source.len;
+        }
+
+        ranges[count++] = (str_t){ .data = source.data + start, .len = end - start };
+        start = end;
+    }
+
+    return count;
+}
+
+static void parallel_split_parse(void *data, const thread_pool_range_t *range)
+{
+    parallel_split_job_t *job = data;
+    arena_t *arena = &job->arenas[range->worker];
+
+    if (!range->scratch || (!arena->base && !arena_create(arena, PARALLEL_SPLIT_ARENA_SIZE))) {
+        atomic_store_explicit(&job->failed, true, memory_order_relaxed);
+        return;
+    }
+
+    for (usize i = range->begin; i < range->end; ++i) {
+        if (atomic_load_explicit(&job->failed, memory_order_relaxed))
+            return;
+
+        arena_scratch_t scratch = arena_scratch_begin(range->scratch);
+
+        if (!job->fn(job->context, arena, range->scratch, job->ranges[i], &job->segments[i]))
+            atomic_store_explicit(&job->failed, true, memory_order_relaxed);
+
+        arena_scratch_end(scratch);
+    }
+}
+
+static void parallel_split_stitch(void *data, const thread_pool_range_t *range)
+{
+    parallel_split_job_t *job = data;
+
+    for (usize i = range->begin; i < range->end; ++i) {
+        parallel_segment_t *segment = &job->segments[i];
+
+        if (segment->count > 0)
+            memcpy(job->items + job->offsets[i] * job->item_size, segment->items,
+                   segment->count * job->item_size);
+    }
+}
+
+void *parallel_split(thread_pool_t *pool, arena_t *arena, str_t source, char delim,
+                     usize item_size, parallel_split_fn_t fn, void *context, usize *count)
+{
+    usize workers = thread_pool_worker_count(pool);
+    void *result = NULL;
+
+    // around 15 KiB of bookkeeping, kept off the stack of whichever thread parses
+    parallel_split_job_t *job = calloc(1, sizeof(*job));
+    if (!job)
+        return NULL;
+
+    job->fn = fn;
+    job->context = context;
+    job->item_size = item_size;
+    atomic_init(&job->failed, false);
+
+    usize range_count =
+        parallel_split_ranges(source, delim, job->ranges,
+                              MIN(workers * PARALLEL_SPLIT_CHUNKS_PER_WORKER,
+                                  PARALLEL_SPLIT_MAX_RANGES),
+                              PARALLEL_SPLIT_MIN_CHUNK);
+
+    thread_pool_parallel_for(pool, 0, range_count, 1, parallel_split_parse, job);
+
+    if (atomic_load(&job->failed))
+        goto done;
+
+    usize total = 0;
+
+    for (usize i = 0; i < range_count; ++i) {
+        job->offsets[i] = total;
+        total += job->segments[i].count;
+    }
+
+    job->items = arena_alloc(arena, (total ? total : 1) * item_size);
+    if (!job->items)
+        goto done;
+
+    thread_pool_parallel_for(pool, 0, range_count, 1, parallel_split_stitch, job);
+
+    *count = total;
+    result = job->items;
+
+done:
+    for (usize i = 0; i < THREAD_POOL_MAX_THREADS; ++i) {
+        if (job->arenas[i].base)
+            arena_destroy(&job->arenas[i]);
+    }
+
+    free(job);
+    return result;
+}
+
+#endif // PARALLEL_SPLIT_IMPLEMENTATION
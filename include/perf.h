@@ -0,0 +1,333 @@
+#pragma once
+
+#include "type_defs.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// hardware counters through perf_event_open, per thread and user space only. Everything
+// degrades to "unavailable" rather than failing: non Linux builds, kernels that refuse the
+// events (perf_event_paranoid, seccomp in containers) or PMUs missing a particular event.
+// Usually driven by TIMER_SCOPE when built with -DPERF_COUNTERS (make counters=1).
+//
+// Work a thread hands to other threads, the helpers of a thread_pool loop, is not on its own
+// counters. Helpers add what they measured to the owner's perf_thread_offload() totals and every
+// sample carries those along, so a phase still counts the pieces that ran on the pool.
+
+typedef enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_BRANCHES,
+    PERF_BRANCH_MISSES,
+    PERF_L1D_READS,
+    PERF_L1D_READ_MISSES,
+    PERF_LLC_REFERENCES,
+    PERF_LLC_MISSES,
+    PERF_EVENT_COUNT,
+} perf_event_t;
+
+// two groups of four, small enough that each group fits the PMU at once on common cores
+#define PERF_GROUP_SIZE 4
+#define PERF_GROUP_COUNT (PERF_EVENT_COUNT / PERF_GROUP_SIZE)
+
+typedef struct {
+    atomic_uint_least64_t values[PERF_EVENT_COUNT];
+    atomic_uint_least32_t available;
+} perf_totals_t;
+
+typedef struct {
+    u64 values[PERF_EVENT_COUNT];
+    u64 enabled[PERF_GROUP_COUNT];
+    u64 running[PERF_GROUP_COUNT];
+    u32 available; // bit per perf_event_t that was read
+    u64 offloaded[PERF_EVENT_COUNT]; // perf_thread_offload() of the sampling thread, scaled
+} perf_sample_t;
+
+bool perf_sample(perf_sample_t *sample);
+void perf_totals_init(perf_totals_t *totals);
+void perf_accumulate(perf_totals_t *totals, const perf_sample_t *start, const perf_sample_t *end);
+void perf_report_header(FILE *out);
+void perf_report_row(FILE *out, const char *label, const perf_totals_t *totals);
+void perf_thread_close(void);
+perf_totals_t *perf_thread_offload(void);
+
+#ifdef PERF_IMPLEMENTATION
+
+#include <errno.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define PERF_HAS_EVENTS 1
+#endif
+
+typedef struct {
+    bool opened;
+    int leaders[PERF_GROUP_COUNT];
+    int fds[PERF_EVENT_COUNT];
+    // position of each event inside its group read, -1 when the event could not be opened
+    int slots[PERF_EVENT_COUNT];
+} perf_thread_t;
+
+static _Thread_local perf_thread_t perf_thread;
+static _Thread_local perf_totals_t perf_offload; // static storage, starts zeroed
+static atomic_int perf_error;
+
+perf_totals_t *perf_thread_offload(void)
+{
+    return &perf_offload;
+}
+
+static void perf_sample_offload(perf_sample_t *sample)
+{
+    for (usize i = 0; i < PERF_EVENT_COUNT; ++i)
+        sample->offloaded[i] = atomic_load_explicit(&perf_offload.values[i], memory_order_relaxed);
+}
+
+#ifdef PERF_HAS_EVENTS
+
+#define PERF_HW_CACHE(cache, op, result) \
+    ((cache) | ((u64)(op) << 8) | ((u64)(result) << 16))
+
+static const struct {
+    u32 type;
+    u64 config;
+} perf_events[PERF_EVENT_COUNT] = {
+    [PERF_CYCLES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    [PERF_INSTRUCTIONS] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    [PERF_BRANCHES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS },
+    [PERF_BRANCH_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    [PERF_L1D_READS] = { PERF_TYPE_HW_CACHE,
+                         PERF_HW_CACHE(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                                       PERF_COUNT_HW_CACHE_RESULT_ACCESS) },
+    [PERF_L1D_READ_MISSES] = { PERF_TYPE_HW_CACHE,
+                               PERF_HW_CACHE(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                                             PERF_COUNT_HW_CACHE_RESULT_MISS) },
+    [PERF_LLC_REFERENCES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES },
+    [PERF_LLC_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+};
+
+static int perf_open_event(perf_event_t event, int group_fd)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+
+    attr.size = sizeof(attr);
+    attr.type = perf_events[event].type;
+    attr.config = perf_events[event].config;
+    attr.disabled = group_fd == -1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format =
+        PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+static void perf_thread_open(void)
+{
+    perf_thread.opened = true;
+
+    for (usize i = 0; i < PERF_EVENT_COUNT; ++i) {
+        perf_thread.fds[i] = -1;
+        perf_thread.slots[i] = -1;
+    }
+
+    for (usize group = 0; group < PERF_GROUP_COUNT; ++group) {
+        int leader = -1;
+        int slot = 0;
+
+        // the first event that opens leads the group, the others are skipped when refused
+        for (usize i = group * PERF_GROUP_SIZE; i < (group + 1) * PERF_GROUP_SIZE; ++i) {
+            int fd = perf_open_event((perf_event_t)i, leader);
+
+            if (fd == -1) {
+                int expected = 0;
+                atomic_compare_exchange_strong(&perf_error, &expected, errno);
+                continue;
+            }
+
+            if (leader == -1)
+                leader = fd;
+
+            perf_thread.fds[i] = fd;
+            perf_thread.slots[i] = slot++;
+        }
+
+        perf_thread.leaders[group] = leader;
+
+        if (leader != -1) {
+            ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+    }
+}
+
+bool perf_sample(perf_sample_t *sample)
+{
+    memset(sample, 0, sizeof(*sample));
+
+    if (!perf_thread.opened)
+        perf_thread_open();
+
+    for (usize group = 0; group < PERF_GROUP_COUNT; ++group) {
+        struct {
+            u64 nr;
+            u64 enabled;
+            u64 running;
+            u64 values[PERF_GROUP_SIZE];
+        } data;
+
+        if (perf_thread.leaders[group] == -1 ||
+            read(perf_thread.leaders[group], &data, sizeof(data)) <= 0)
+            continue;
+
+        sample->enabled[group] = data.enabled;
+        sample->running[group] = data.running;
+
+        for (usize i = group * PERF_GROUP_SIZE; i < (group + 1) * PERF_GROUP_SIZE; ++i) {
+            int slot = perf_thread.slots[i];
+            if (slot < 0 || (u64)slot >= data.nr)
+                continue;
+
+            sample->values[i] = data.values[slot];
+            sample->available |= 1u << i;
+        }
+    }
+
+    perf_sample_offload(sample);
+    return sample->available != 0;
+}
+
+void perf_thread_close(void)
+{
+    if (!perf_thread.opened)
+        return;
+
+    for (usize i = 0; i < PERF_EVENT_COUNT; ++i) {
+        if (perf_thread.fds[i] != -1)
+            close(perf_thread.fds[i]);
+    }
+
+    perf_thread.opened = false;
+}
+
+#else
+
+bool perf_sample(perf_sample_t *sample)
+{
+    memset(sample, 0, sizeof(*sample));
+
+    if (!perf_thread.opened) {
+        perf_thread.opened = true;
+        atomic_store(&perf_error, ENOSYS);
+    }
+
+    perf_sample_offload(sample);
+    return false;
+}
+
+void perf_thread_close(void)
+{
+    perf_thread.opened = false;
+}
+
+#endif // PERF_HAS_EVENTS
+
+void perf_totals_init(perf_totals_t *totals)
+{
+    for (usize i = 0; i < PERF_EVENT_COUNT; ++i)
+        atomic_init(&totals->values[i], 0);
+
+    atomic_init(&totals->available, 0);
+}
+
+// deltas are scaled by enabled / running time, which only differ when the kernel had to
+// multiplex the group with other events. Offloaded counts were scaled by the helpers already
+void perf_accumulate(perf_totals_t *totals, const perf_sample_t *start, const perf_sample_t *end)
+{
+    u32 available = start->available & end->available;
+
+    for (usize i = 0; i < PERF_EVENT_COUNT; ++i) {
+        if (!(available & (1u << i)))
+            continue;
+
+        usize group = i / PERF_GROUP_SIZE;
+        u64 enabled = end->enabled[group] - start->enabled[group];
+        u64 running = end->running[group] - start->running[group];
+        u64 delta = end->values[i] - start->values[i];
+
+        if (running == 0) {
+            available &= ~(1u << i);
+            continue;
+        }
+
+        if (running != enabled)
+            delta = (u64)((double)delta * (double)enabled / (double)running);
+
+        delta += end->offloaded[i] - start->offloaded[i];
+        atomic_fetch_add_explicit(&totals->values[i], delta, memory_order_relaxed);
+    }
+
+    atomic_fetch_or_explicit(&totals->available, available, memory_order_relaxed);
+}
+
+void perf_report_header(FILE *out)
+{
+    int error = atomic_load(&perf_error);
+
+    if (error != 0)
+        fprintf(out, "perf: perf_event_open failed for some events (%s)\n", strerror(error));
+
+    fprintf(out, "perf: %-16s %8s %14s %14s %10s %10s %10s\n", "phase", "IPC", "cycles",
+            "instructions", "branch %", "L1D %", "LLC %");
+}
+
+static void perf_format_ratio(char *buffer, usize size, u32 available, const perf_totals_t *totals,
+                              perf_event_t num, perf_event_t den, double scale)
+{
+    u64 denominator = atomic_load(&totals->values[den]);
+
+    if (!(available & (1u << num)) || !(available & (1u << den)) || denominator == 0) {
+        snprintf(buffer, size, "-");
+        return;
+    }
+
+    snprintf(buffer, size, "%.2f",
+             (double)atomic_load(&totals->values[num]) * scale / (double)denominator);
+}
+
+static void perf_format_count(char *buffer, usize size, u32 available, const perf_totals_t *totals,
+                              perf_event_t event)
+{
+    if (!(available & (1u << event))) {
+        snprintf(buffer, size, "-");
+        return;
+    }
+
+    snprintf(buffer, size, "%llu", (unsigned long long)atomic_load(&totals->values[event]));
+}
+
+void perf_report_row(FILE *out, const char *label, const perf_totals_t *totals)
+{
+    u32 available = atomic_load(&totals->available);
+    char ipc[32], cycles[32], instructions[32], branch[32], l1d[32], llc[32];
+
+    perf_format_ratio(ipc, sizeof(ipc), available, totals, PERF_INSTRUCTIONS, PERF_CYCLES, 1.0);
+    perf_format_count(cycles, sizeof(cycles), available, totals, PERF_CYCLES);
+    perf_format_count(instructions, sizeof(instructions), available, totals, PERF_INSTRUCTIONS);
+    perf_format_ratio(branch, sizeof(branch), available, totals, PERF_BRANCH_MISSES, PERF_BRANCHES,
+                      100.0);
+    perf_format_ratio(l1d, sizeof(l1d), available, totals, PERF_L1D_READ_MISSES, PERF_L1D_READS,
+                      100.0);
+    perf_format_ratio(llc, sizeof(llc), available, totals, PERF_LLC_MISSES, PERF_LLC_REFERENCES,
+                      100.0);
+
+    fprintf(out, "perf: %-16s %8s %14s %14s %10s %10s %10s\n", label, ipc, cycles, instructions,
+            branch, l1d, llc);
+}
+
+#endif // PERF_IMPLEMENTATION
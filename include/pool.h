@@ -0,0 +1,65 @@
+#pragma once
+
+#include "type_defs.h"
+#include "arena.h"
+#include <stdalign.h>
+#include <stdbool.h>
+
+// slots are packed into slabs carved from the arena and live as long as it does, a run that
+// cleans the arena gets the same slabs back for the next one
+typedef struct {
+    arena_t *arena;
+    usize slot_size;
+    usize slot_align;
+    usize slab_slots;
+    unsigned char *cursor;
+    unsigned char *end;
+} pool_t;
+
+#define POOL_SLAB_SLOTS 256
+
+#define pool_init_type(pool, arena, type, slab_slots) \
+    pool_init((pool), (arena), sizeof(type), alignof(type), (slab_slots))
+
+bool pool_init(pool_t *pool, arena_t *arena, usize slot_size, usize slot_align, usize slab_slots);
+void *pool_alloc(pool_t *pool);
+
+#ifdef POOL_IMPLEMENTATION
+
+#include <assert.h>
+
+bool pool_init(pool_t *pool, arena_t *arena, usize slot_size, usize slot_align, usize slab_slots)
+{
+    if (!pool || !arena || slot_size == 0 || slab_slots == 0)
+        return false;
+
+    assert(slot_align != 0 && (slot_align & (slot_align - 1)) == 0);
+
+    pool->arena = arena;
+    pool->slot_size = (slot_size + slot_align - 1) & ~(slot_align - 1);
+    pool->slot_align = slot_align;
+    pool->slab_slots = slab_slots;
+    pool->cursor = NULL;
+    pool->end = NULL;
+    return true;
+}
+
+void *pool_alloc(pool_t *pool)
+{
+    if (pool->cursor == pool->end) {
+        usize slab_size = pool->slot_size * pool->slab_slots;
+        unsigned char *slab = arena_alloc_aligned(pool->arena, slab_size, pool->slot_align);
+        if (!slab)
+            return NULL;
+
+        pool->cursor = slab;
+        pool->end = slab + slab_size;
+    }
+
+    void *ptr = pool->cursor;
+    pool->cursor += pool->slot_size;
+
+    return ptr;
+}
+
+#endif // POOL_IMPLEMENTATION
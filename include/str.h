@@ -0,0 +1,146 @@
+#pragma once
+
+#include "type_defs.h"
+#include "arena.h"
+#include "utils.h"
+#include <stdbool.h>
+
+typedef struct {
+    const char *data;
+    usize len;
+} str_t;
+
+typedef struct {
+    str_t *items;
+    usize size;
+    usize capacity;
+} str_chunks_t;
+
+typedef struct {
+    str_t rest;
+    str_t delim;
+} split_iter_t;
+
+#define STR(literal) ((str_t){ .data = (literal), .len = sizeof(literal) - 1 })
+
+str_t str_from_cstr(const char *cstr);
+bool str_eq(str_t a, str_t b);
+str_chunks_t *str_split(arena_t *a, str_t input, str_t delim);
+split_iter_t split_iter_init(str_t input, str_t delim);
+bool split_iter_next(split_iter_t *iter, str_t *token);
+bool str_parse_int(str_t source, int base, i64 *value);
+str_t str_trim_left(str_t str);
+str_t str_trim_right(str_t str);
+str_t str_trim(str_t str);
+
+#ifdef STR_IMPLEMENTATION
+
+#include <assert.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_IMPLEMENTATION
+#include "arena.h"
+
+str_t str_from_cstr(const char *cstr)
+{
+    return (str_t){ .data = cstr, .len = strlen(cstr) };
+}
+
+bool str_eq(str_t a, str_t b)
+{
+    return a.len == b.len && memcmp(a.data, b.data, a.len) == 0;
+}
+
+str_chunks_t *str_split(arena_t *arena, str_t input, str_t delim)
+{
+    str_chunks_t *chunks = arena_alloc(arena, sizeof(*chunks));
+    if (!chunks)
+        return NULL;
+
+    arena_da_init(arena, chunks, ARENA_DA_CAPACITY);
+
+    if (delim.len == 0)
+        return chunks;
+
+    str_t rest = input;
+    const char *next_delim = NULL;
+
+    while ((next_delim = find_delim(rest.data, rest.len, delim.data, delim.len)) != NULL) {
+        usize len = (usize)(next_delim - rest.data);
+
+        arena_da_append(arena, chunks, ((str_t){ .data = rest.data, .len = len }));
+
+        rest.data += len + delim.len;
+        rest.len -= len + delim.len;
+    }
+
+    if (rest.len > 0)
+        arena_da_append(arena, chunks, rest);
+
+    return chunks;
+}
+
+split_iter_t split_iter_init(str_t input, str_t delim)
+{
+    return (split_iter_t){ .rest = input, .delim = delim };
+}
+
+// yields the same tokens as str_split, one at a time and without allocating
+bool split_iter_next(split_iter_t *iter, str_t *token)
+{
+    if (iter->rest.len == 0 || iter->delim.len == 0)
+        return false;
+
+    const char *next_delim =
+        find_delim(iter->rest.data, iter->rest.len, iter->delim.data, iter->delim.len);
+
+    if (!next_delim) {
+        *token = iter->rest;
+        iter->rest.data += iter->rest.len;
+        iter->rest.len = 0;
+        return true;
+    }
+
+    usize len = (usize)(next_delim - iter->rest.data);
+    *token = (str_t){ .data = iter->rest.data, .len = len };
+
+    iter->rest.data += len + iter->delim.len;
+    iter->rest.len -= len + iter->delim.len;
+    return true;
+}
+
+// the whole of source has to be the number, callers fail their parse instead of exiting
+bool str_parse_int(str_t source, int base, i64 *value)
+{
+    parse_err_t error = PARSE_OK;
+
+    return parse_i64(source.data, source.len, base, value, &error) == source.len &&
+           error == PARSE_OK;
+}
+
+str_t str_trim_left(str_t str)
+{
+    while (str.len > 0 && isspace((unsigned char)str.data[0])) {
+        str.data++;
+        str.len--;
+    }
+
+    return str;
+}
+
+str_t str_trim_right(str_t str)
+{
+    while (str.len > 0 && isspace((unsigned char)str.data[str.len - 1]))
+        str.len--;
+
+    return str;
+}
+
+str_t str_trim(str_t str)
+{
+    return str_trim_left(str_trim_right(str));
+}
+
+#endif // STR_IMPLEMENTATION
@@ -0,0 +1,506 @@
+#pragma once
+
+#include "type_defs.h"
+#include "arena.h"
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#ifdef PERF_COUNTERS
+#include "perf.h"
+#endif
+
+// work-stealing pool for data-parallel loops
+//
+//     thread_pool_parallel_for(thread_pool_default(), 0, count, 1024, count_range, &ctx);
+//
+// splits [begin, end) in halves until a piece is at most grain long. Every worker owns a
+// Chase-Lev deque, it pushes the upper halves and works on the lower one, idle workers steal
+// the oldest and so largest pieces. The calling thread is worker 0 and the call returns once
+// every index ran. Each piece gets the index of the worker running it, for per-worker partial
+// results sized by thread_pool_worker_count, and that worker's scratch arena which is rewound
+// after the piece. One loop runs at a time: nested calls and calls while another thread owns
+// the pool run serially on the caller instead of waiting.
+
+#define THREAD_POOL_MAX_THREADS 64
+#define THREAD_POOL_DEQUE_SIZE 64     // power of two, binary splitting needs log2(range) slots
+#define THREAD_POOL_SCRATCH_SIZE (64 * 1024)
+#define THREAD_POOL_SPIN 64           // failed steals before yielding the cpu
+#define THREAD_POOL_ENV "AOC_THREADS" // worker count of the default pool, all cpus when unset
+
+typedef struct {
+    usize begin;
+    usize end;
+    usize worker;
+    arena_t *scratch;
+} thread_pool_range_t;
+
+typedef void (*thread_pool_fn_t)(void *context, const thread_pool_range_t *range);
+
+// slots are read by thieves while the owner may reuse them, a thief that read a reused slot
+// always loses the race on top so relaxed atomics are enough to keep that well defined
+typedef struct {
+    atomic_size_t begin;
+    atomic_size_t end;
+} thread_pool_slot_t;
+
+typedef struct {
+    alignas(64) _Atomic(i64) top;
+    alignas(64) _Atomic(i64) bottom;
+    thread_pool_slot_t slots[THREAD_POOL_DEQUE_SIZE];
+} thread_pool_deque_t;
+
+typedef struct thread_pool thread_pool_t;
+
+typedef struct {
+    thread_pool_deque_t deque;
+    thread_pool_t *pool;
+    usize index;
+    u64 rng; // victim selection
+    arena_t scratch;
+    pthread_t thread;
+} thread_pool_worker_t;
+
+struct thread_pool {
+    arena_t arena;
+    thread_pool_worker_t *workers;
+    usize worker_count;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    u64 generation; // bumped under lock for every loop
+    bool stop;
+    atomic_flag running;
+    atomic_size_t busy; // helpers that have not left the current loop yet
+    // the current loop, only written while no helper is inside one
+    thread_pool_fn_t fn;
+    void *context;
+    usize grain;
+#ifdef PERF_COUNTERS
+    perf_totals_t *perf_owner; // the caller's offload totals, helpers count their pieces there
+#endif
+    alignas(64) atomic_size_t pending; // indices not run yet
+};
+
+usize thread_pool_cpu_count(void);
+bool thread_pool_create(thread_pool_t *pool, usize threads);
+void thread_pool_destroy(thread_pool_t *pool);
+usize thread_pool_worker_count(const thread_pool_t *pool);
+void thread_pool_parallel_for(thread_pool_t *pool, usize begin, usize end, usize grain,
+                              thread_pool_fn_t fn, void *context);
+thread_pool_t *thread_pool_default(void);
+
+#ifdef THREAD_POOL_IMPLEMENTATION
+
+#include <sched.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct {
+    usize begin;
+    usize end;
+} thread_pool_span_t;
+
+static _Thread_local thread_pool_worker_t *thread_pool_current;
+
+usize thread_pool_cpu_count(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (usize)count : 1;
+}
+
+// owner only, fails when the deque is full and the caller then runs the span itself
+static bool thread_pool_push(thread_pool_deque_t *deque, usize begin, usize end)
+{
+    i64 bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    i64 top = atomic_load_explicit(&deque->top, memory_order_acquire);
+
+    if (bottom - top >= THREAD_POOL_DEQUE_SIZE)
+        return false;
+
+    thread_pool_slot_t *slot = &deque->slots[bottom & (THREAD_POOL_DEQUE_SIZE - 1)];
+    atomic_store_explicit(&slot->begin, begin, memory_order_relaxed);
+    atomic_store_explicit(&slot->end, end, memory_order_relaxed);
+
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    return true;
+}
+
+// owner only, newest first
+static bool thread_pool_take(thread_pool_deque_t *deque, thread_pool_span_t *span)
+{
+    i64 bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    i64 top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (top > bottom) {
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return false;
+    }
+
+    thread_pool_slot_t *slot = &deque->slots[bottom & (THREAD_POOL_DEQUE_SIZE - 1)];
+    span->begin = atomic_load_explicit(&slot->begin, memory_order_relaxed);
+    span->end = atomic_load_explicit(&slot->end, memory_order_relaxed);
+
+    if (top < bottom)
+        return true;
+
+    // last one left, race the thieves for it
+    bool taken = atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                         memory_order_seq_cst,
+                                                         memory_order_relaxed);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    return taken;
+}
+
+// any thread, oldest first
+static bool thread_pool_steal_from(thread_pool_deque_t *deque, thread_pool_span_t *span)
+{
+    i64 top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    i64 bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+    if (top >= bottom)
+        return false;
+
+    thread_pool_slot_t *slot = &deque->slots[top & (THREAD_POOL_DEQUE_SIZE - 1)];
+    span->begin = atomic_load_explicit(&slot->begin, memory_order_relaxed);
+    span->end = atomic_load_explicit(&slot->end, memory_order_relaxed);
+
+    return atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                   memory_order_seq_cst, memory_order_relaxed);
+}
+
+static bool thread_pool_steal(thread_pool_t *pool, thread_pool_worker_t *worker,
+                              thread_pool_span_t *span)
+{
+    // xorshift, only has to spread the thieves over different victims
+    worker->rng ^= worker->rng << 13;
+    worker->rng ^= worker->rng >> 7;
+    worker->rng ^= worker->rng << 17;
+
+    usize start = (usize)(worker->rng % pool->worker_count);
+
+    for (usize i = 0; i < pool->worker_count; ++i) {
+        thread_pool_worker_t *victim = &pool->workers[(start + i) % pool->worker_count];
+
+        if (victim != worker && thread_pool_steal_from(&victim->deque, span))
+            return true;
+    }
+
+    return false;
+}
+
+static void thread_pool_run(thread_pool_t *pool, thread_pool_worker_t *worker,
+                            thread_pool_span_t span)
+{
+    while (span.end - span.begin > pool->grain) {
+        usize middle = span.begin + (span.end - span.begin) / 2;
+
+        if (!thread_pool_push(&worker->deque, middle, span.end))
+            break;
+
+        span.end = middle;
+    }
+
+    arena_scratch_t scratch = arena_scratch_begin(&worker->scratch);
+
+    thread_pool_range_t range = {
+        .begin = span.begin,
+        .end = span.end,
+        .worker = worker->index,
+        .scratch = &worker->scratch,
+    };
+
+#ifdef PERF_COUNTERS
+    // worker 0 is the caller, whose own counters already see its pieces
+    perf_sample_t start = { 0 };
+    if (worker->index != 0)
+        perf_sample(&start);
+#endif
+
+    pool->fn(pool->context, &range);
+
+#ifdef PERF_COUNTERS
+    if (worker->index != 0) {
+        perf_sample_t end = { 0 };
+        perf_sample(&end);
+        perf_accumulate(pool->perf_owner, &start, &end);
+    }
+#endif
+
+    arena_scratch_end(scratch);
+
+    atomic_fetch_sub_explicit(&pool->pending, span.end - span.begin, memory_order_acq_rel);
+}
+
+static void thread_pool_work(thread_pool_t *pool, thread_pool_worker_t *worker)
+{
+    usize idle = 0;
+
+    while (atomic_load_explicit(&pool->pending, memory_order_acquire) > 0) {
+        thread_pool_span_t span = { 0 };
+
+        if (thread_pool_take(&worker->deque, &span) || thread_pool_steal(pool, worker, &span)) {
+            thread_pool_run(pool, worker, span);
+            idle = 0;
+        } else if (++idle >= THREAD_POOL_SPIN) {
+            sched_yield();
+            idle = 0;
+        }
+    }
+}
+
+static void *thread_pool_worker_main(void *arg)
+{
+    thread_pool_worker_t *worker = arg;
+    thread_pool_t *pool = worker->pool;
+    u64 seen = 0;
+
+    thread_pool_current = worker;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+
+        while (pool->generation == seen && !pool->stop)
+            pthread_cond_wait(&pool->wake, &pool->lock);
+
+        bool stop = pool->stop;
+        seen = pool->generation;
+
+        pthread_mutex_unlock(&pool->lock);
+
+        if (stop)
+            break;
+
+        thread_pool_work(pool, worker);
+        atomic_fetch_sub_explicit(&pool->busy, 1, memory_order_release);
+    }
+
+#ifdef PERF_COUNTERS
+    perf_thread_close();
+#endif
+
+    return NULL;
+}
+
+static void thread_pool_stop(thread_pool_t *pool, usize started)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (usize i = 1; i < started; ++i)
+        pthread_join(pool->workers[i].thread, NULL);
+}
+
+bool thread_pool_create(thread_pool_t *pool, usize threads)
+{
+    if (!pool)
+        return false;
+
+    if (threads == 0)
+        threads = thread_pool_cpu_count();
+
+    if (threads > THREAD_POOL_MAX_THREADS)
+        threads = THREAD_POOL_MAX_THREADS;
+
+    *pool = (thread_pool_t){ .worker_count = threads, .running = ATOMIC_FLAG_INIT };
+    atomic_init(&pool->busy, 0);
+    atomic_init(&pool->pending, 0);
+
+    if (!arena_create(&pool->arena, threads * sizeof(thread_pool_worker_t) + 64))
+        return false;
+
+    pool->workers = arena_alloc_aligned(&pool->arena, threads * sizeof(thread_pool_worker_t),
+                                        alignof(thread_pool_worker_t));
+    if (!pool->workers)
+        goto cleanup_arena;
+
+    for (usize i = 0; i < threads; ++i) {
+        thread_pool_worker_t *worker = &pool->workers[i];
+
+        *worker = (thread_pool_worker_t){ .pool = pool, .index = i };
+        worker->rng = (i + 1) * 0x9e3779b97f4a7c15ull;
+        atomic_init(&worker->deque.top, 0);
+        atomic_init(&worker->deque.bottom, 0);
+
+        if (!arena_create(&worker->scratch, THREAD_POOL_SCRATCH_SIZE)) {
+            for (usize j = 0; j < i; ++j)
+                arena_destroy(&pool->workers[j].scratch);
+
+            goto cleanup_arena;
+        }
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+
+    // worker 0 is whichever thread calls parallel_for
+    for (usize i = 1; i < threads; ++i) {
+        if (pthread_create(&pool->workers[i].thread, NULL, thread_pool_worker_main,
+                           &pool->workers[i]) != 0) {
+            thread_pool_stop(pool, i);
+            goto cleanup_workers;
+        }
+    }
+
+    return true;
+
+cleanup_workers:
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+
+    for (usize i = 0; i < threads; ++i)
+        arena_destroy(&pool->workers[i].scratch);
+
+cleanup_arena:
+    arena_destroy(&pool->arena);
+    return false;
+}
+
+void thread_pool_destroy(thread_pool_t *pool)
+{
+    if (!pool || !pool->workers)
+        return;
+
+    thread_pool_stop(pool, pool->worker_count);
+
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+
+    for (usize i = 0; i < pool->worker_count; ++i)
+        arena_destroy(&pool->workers[i].scratch);
+
+    arena_destroy(&pool->arena);
+    pool->workers = NULL;
+}
+
+usize thread_pool_worker_count(const thread_pool_t *pool)
+{
+    return pool ? pool->worker_count : 1;
+}
+
+static void thread_pool_serial_for(usize begin, usize end, usize grain, thread_pool_fn_t fn,
+                                   void *context)
+{
+    thread_pool_worker_t *worker = thread_pool_current;
+    arena_t local = { 0 };
+    arena_t *scratch = worker ? &worker->scratch : &local;
+
+    if (!worker && !arena_create(&local, THREAD_POOL_SCRATCH_SIZE))
+        scratch = NULL;
+
+    for (usize i = begin; i < end;) {
+        usize next = end - i > grain ? i + grain : end;
+        arena_scratch_t mark = { 0 };
+
+        if (scratch)
+            mark = arena_scratch_begin(scratch);
+
+        thread_pool_range_t range = {
+            .begin = i,
+            .end = next,
+            .worker = worker ? worker->index : 0,
+            .scratch = scratch,
+        };
+        fn(context, &range);
+
+        if (scratch)
+            arena_scratch_end(mark);
+
+        i = next;
+    }
+
+    if (!worker && scratch)
+        arena_destroy(&local);
+}
+
+void thread_pool_parallel_for(thread_pool_t *pool, usize begin, usize end, usize grain,
+                              thread_pool_fn_t fn, void *context)
+{
+    if (begin >= end)
+        return;
+
+    if (grain == 0)
+        grain = 1;
+
+    if (!pool || pool->worker_count < 2 || end - begin <= grain || thread_pool_current ||
+        atomic_flag_test_and_set_explicit(&pool->running, memory_order_acquire)) {
+        thread_pool_serial_for(begin, end, grain, fn, context);
+        return;
+    }
+
+    thread_pool_worker_t *self = &pool->workers[0];
+
+    pool->fn = fn;
+    pool->context = context;
+    pool->grain = grain;
+#ifdef PERF_COUNTERS
+    pool->perf_owner = perf_thread_offload();
+#endif
+    atomic_store_explicit(&pool->pending, end - begin, memory_order_relaxed);
+    atomic_store_explicit(&pool->busy, pool->worker_count - 1, memory_order_relaxed);
+    thread_pool_push(&self->deque, begin, end);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->generation += 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    thread_pool_current = self;
+    thread_pool_work(pool, self);
+    thread_pool_current = NULL;
+
+    // the next loop rewrites fn and context, so every helper has to be out of this one first
+    while (atomic_load_explicit(&pool->busy, memory_order_acquire) > 0)
+        sched_yield();
+
+    atomic_flag_clear_explicit(&pool->running, memory_order_release);
+}
+
+static thread_pool_t thread_pool_shared;
+static thread_pool_t *thread_pool_shared_ptr;
+static pthread_once_t thread_pool_shared_once = PTHREAD_ONCE_INIT;
+
+// exit() from inside a loop, a failed parse on a worker say, leaves helpers spinning on work
+// that never finishes and joining them would hang, the process is going away so they are left
+static void thread_pool_shared_destroy(void)
+{
+    if (atomic_flag_test_and_set_explicit(&thread_pool_shared.running, memory_order_acquire))
+        return;
+
+    thread_pool_destroy(thread_pool_shared_ptr);
+}
+
+static void thread_pool_shared_init(void)
+{
+    usize threads = 0;
+    const char *env = getenv(THREAD_POOL_ENV);
+
+    if (env) {
+        char *end = NULL;
+        unsigned long parsed = strtoul(env, &end, 10);
+
+        if (end != env && *end == '\0')
+            threads = (usize)parsed;
+    }
+
+    if (thread_pool_create(&thread_pool_shared, threads)) {
+        thread_pool_shared_ptr = &thread_pool_shared;
+        atexit(thread_pool_shared_destroy);
+    }
+}
+
+// created on first use and torn down at exit unless a loop is still running, NULL when it could
+// not be created which parallel_for treats as a serial loop
+thread_pool_t *thread_pool_default(void)
+{
+    pthread_once(&thread_pool_shared_once, thread_pool_shared_init);
+    return thread_pool_shared_ptr;
+}
+
+#endif // THREAD_POOL_IMPLEMENTATION
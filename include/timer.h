@@ -0,0 +1,272 @@
+#pragma once
+
+#include "type_defs.h"
+#include <stdio.h>
+
+// named phase timers, compiled in with -DTIMERS (make timers=1) and nothing at all otherwise
+//
+//     TIMER_SCOPE("parse");
+//
+// times from the statement to the end of the enclosing block and aggregates count, total, min
+// and max per label. Labels are compared by content so the same name from different call sites
+// lands in one row, the report goes to stderr at exit in first-use order. With -DPERF_COUNTERS
+// (make counters=1) every scope also samples the hardware counters from perf.h.
+
+#if defined(PERF_COUNTERS) && !defined(TIMERS)
+#define TIMERS
+#endif
+
+#ifndef TIMER_MAX_LABELS
+#define TIMER_MAX_LABELS 32
+#endif
+
+void timer_report(FILE *out);
+
+#ifdef TIMERS
+
+#include <stdatomic.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TIMER_HAS_TSC 1
+#endif
+
+#ifdef PERF_COUNTERS
+#include "perf.h"
+#endif
+
+typedef struct {
+    const char *label;
+    atomic_uint_least64_t count;
+    atomic_uint_least64_t total;
+    atomic_uint_least64_t min;
+    atomic_uint_least64_t max;
+#ifdef PERF_COUNTERS
+    perf_totals_t perf;
+#endif
+} timer_stat_t;
+
+typedef struct {
+    timer_stat_t *stat;
+    u64 start;
+#ifdef PERF_COUNTERS
+    perf_sample_t perf;
+#endif
+} timer_scope_t;
+
+timer_stat_t *timer_register(const char *label);
+
+// ticks are TSC cycles where available, converted to nanoseconds only when reporting
+static inline u64 timer_ticks(void)
+{
+#ifdef TIMER_HAS_TSC
+    return __rdtsc();
+#else
+    struct timespec now = { 0 };
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000ull + (u64)now.tv_nsec;
+#endif
+}
+
+// every call site caches its row so the label lookup only happens on the first pass
+static inline timer_scope_t timer_scope_begin(timer_stat_t *_Atomic *site, const char *label)
+{
+    timer_stat_t *stat = atomic_load_explicit(site, memory_order_acquire);
+
+    if (!stat) {
+        stat = timer_register(label);
+        atomic_store_explicit(site, stat, memory_order_release);
+    }
+
+    timer_scope_t scope = { .stat = stat };
+
+    // counters are read outside the timed span so the syscalls do not show up in the timings
+#ifdef PERF_COUNTERS
+    perf_sample(&scope.perf);
+#endif
+
+    scope.start = timer_ticks();
+    return scope;
+}
+
+static inline void timer_scope_end(timer_scope_t *scope)
+{
+    u64 elapsed = timer_ticks() - scope->start;
+    timer_stat_t *stat = scope->stat;
+
+    if (!stat)
+        return;
+
+#ifdef PERF_COUNTERS
+    perf_sample_t perf = { 0 };
+    perf_sample(&perf);
+    perf_accumulate(&stat->perf, &scope->perf, &perf);
+#endif
+
+    atomic_fetch_add_explicit(&stat->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stat->total, elapsed, memory_order_relaxed);
+
+    u64 min = atomic_load_explicit(&stat->min, memory_order_relaxed);
+    while (elapsed < min && !atomic_compare_exchange_weak_explicit(
+                                &stat->min, &min, elapsed, memory_order_relaxed,
+                                memory_order_relaxed))
+        ;
+
+    u64 max = atomic_load_explicit(&stat->max, memory_order_relaxed);
+    while (elapsed > max && !atomic_compare_exchange_weak_explicit(
+                                &stat->max, &max, elapsed, memory_order_relaxed,
+                                memory_order_relaxed))
+        ;
+}
+
+#define TIMER_CAT(a, b) TIMER_CAT_(a, b)
+#define TIMER_CAT_(a, b) a##b
+
+#define TIMER_SCOPE(label)                                                             \
+    static timer_stat_t *_Atomic TIMER_CAT(timer_site_, __LINE__) = NULL;              \
+    timer_scope_t TIMER_CAT(timer_scope_, __LINE__)                                    \
+        __attribute__((cleanup(timer_scope_end))) =                                    \
+            timer_scope_begin(&TIMER_CAT(timer_site_, __LINE__), (label))
+
+#else
+
+#define TIMER_SCOPE(label) ((void)0)
+
+#endif // TIMERS
+
+#ifdef TIMER_IMPLEMENTATION
+
+#ifdef TIMERS
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static timer_stat_t timer_stats[TIMER_MAX_LABELS];
+static usize timer_stats_len;
+static pthread_mutex_t timer_lock = PTHREAD_MUTEX_INITIALIZER;
+static u64 timer_start_ticks;
+static u64 timer_start_ns;
+
+static u64 timer_now_ns(void)
+{
+    struct timespec now = { 0 };
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000ull + (u64)now.tv_nsec;
+}
+
+static void timer_report_at_exit(void)
+{
+    timer_report(stderr);
+}
+
+timer_stat_t *timer_register(const char *label)
+{
+    timer_stat_t *stat = NULL;
+
+    pthread_mutex_lock(&timer_lock);
+
+    if (timer_stats_len == 0) {
+        timer_start_ticks = timer_ticks();
+        timer_start_ns = timer_now_ns();
+        atexit(timer_report_at_exit);
+    }
+
+    for (usize i = 0; i < timer_stats_len; ++i) {
+        if (strcmp(timer_stats[i].label, label) == 0) {
+            stat = &timer_stats[i];
+            break;
+        }
+    }
+
+    // past TIMER_MAX_LABELS the scope still runs, it just is not recorded
+    if (!stat && timer_stats_len < TIMER_MAX_LABELS) {
+        stat = &timer_stats[timer_stats_len++];
+        stat->label = label;
+        atomic_init(&stat->count, 0);
+        atomic_init(&stat->total, 0);
+        atomic_init(&stat->min, UINT64_MAX);
+        atomic_init(&stat->max, 0);
+#ifdef PERF_COUNTERS
+        perf_totals_init(&stat->perf);
+#endif
+    }
+
+    pthread_mutex_unlock(&timer_lock);
+    return stat;
+}
+
+// nanoseconds per tick, the TSC rate is measured against the monotonic clock over the whole
+// run so far, topped up with a short sleep when the run was too short to be accurate
+static double timer_ns_per_tick(void)
+{
+#ifdef TIMER_HAS_TSC
+    u64 elapsed_ns = timer_now_ns() - timer_start_ns;
+
+    if (elapsed_ns < 10000000) {
+        struct timespec wait = { .tv_sec = 0, .tv_nsec = (long)(10000000 - elapsed_ns) };
+        nanosleep(&wait, NULL);
+    }
+
+    u64 ticks = timer_ticks() - timer_start_ticks;
+    elapsed_ns = timer_now_ns() - timer_start_ns;
+    return ticks ? (double)elapsed_ns / (double)ticks : 1.0;
+#else
+    return 1.0;
+#endif
+}
+
+void timer_report(FILE *out)
+{
+    if (!out)
+        return;
+
+    pthread_mutex_lock(&timer_lock);
+
+    if (timer_stats_len > 0) {
+        double scale = timer_ns_per_tick() / 1000.0;
+
+        fprintf(out, "timer: %-16s %10s %14s %12s %12s %12s\n", "phase", "count", "total us",
+                "mean us", "min us", "max us");
+
+        for (usize i = 0; i < timer_stats_len; ++i) {
+            timer_stat_t *stat = &timer_stats[i];
+            u64 count = atomic_load(&stat->count);
+            u64 total = atomic_load(&stat->total);
+
+            if (count == 0)
+                continue;
+
+            fprintf(out, "timer: %-16s %10llu %14.3f %12.3f %12.3f %12.3f\n", stat->label,
+                    (unsigned long long)count, (double)total * scale,
+                    (double)total * scale / (double)count,
+                    (double)atomic_load(&stat->min) * scale,
+                    (double)atomic_load(&stat->max) * scale);
+        }
+
+#ifdef PERF_COUNTERS
+        perf_report_header(out);
+
+        for (usize i = 0; i < timer_stats_len; ++i) {
+            if (atomic_load(&timer_stats[i].count) > 0)
+                perf_report_row(out, timer_stats[i].label, &timer_stats[i].perf);
+        }
+#endif
+    }
+
+    pthread_mutex_unlock(&timer_lock);
+}
+
+#else
+
+void timer_report(FILE *out)
+{
+    (void)out;
+}
+
+#endif // TIMERS
+
+#endif // TIMER_IMPLEMENTATION
@@ -9,26 +9,186 @@ typedef struct {
     usize capacity;
 } string_chunks_t;
 
+typedef enum {
+    PARSE_OK,
+    PARSE_EMPTY,
+    PARSE_OVERFLOW,
+} parse_err_t;
+
 string_chunks_t *split_str(arena_t *a, const char *input, const char *delim);
-i64 parse_int(const char *source, int base);
+const char *find_delim(const char *data, usize len, const char *delim, usize delim_len);
+usize parse_u64(const char *source, usize len, int base, u64 *value, parse_err_t *error);
+usize parse_i64(const char *source, usize len, int base, i64 *value, parse_err_t *error);
+usize count_char(const char *data, usize len, char c);
+u32 *parse_u32_list(arena_t *a, const char *source, usize len, char sep, usize *count);
+u64 *parse_u64_list(arena_t *a, const char *source, usize len, char sep, usize *count);
+i64 *parse_i64_list(arena_t *a, const char *source, usize len, char sep, usize *count);
+bool radix_sort_u32(arena_t *a, u32 *items, usize count);
+bool radix_sort_u64(arena_t *a, u64 *items, usize count);
+u32 select_nth_u32(u32 *items, usize count, usize nth);
+u64 select_nth_u64(u64 *items, usize count, usize nth);
 char *trim_left(char *str);
 char *trim_right(char *str);
 char *trim(char *str);
 
+#ifndef MIN
+#define MIN(A, B) (A > B ? B : A)
+#endif
+
+#ifndef MAX
+#define MAX(A, B) (A > B ? A : B)
+#endif
+
 #ifdef UTILS_IMPLEMENTATION
 
+#include <assert.h>
 #include <string.h>
 #include <ctype.h>
-#include <errno.h>
+#include <stdatomic.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define UTILS_HAS_X86_SIMD 1
+#endif
 
 #define ARENA_IMPLEMENTATION
 #include "arena.h"
 
 #define STRING_CHUNKS_CAPACITY 256
 
-#define MIN(A, B) (A > B ? B : A)
-#define MAX(A, B) (A > B ? A : B)
+static const char *find_delim_scalar(const char *data, usize len, const char *delim,
+                                     usize delim_len)
+{
+    if (delim_len > len)
+        return NULL;
+
+    const char *last = data + len - delim_len;
+
+    for (const char *pos = data; pos <= last; ++pos) {
+        pos = memchr(pos, delim[0], (usize)(last - pos) + 1);
+        if (!pos)
+            return NULL;
+
+        if (memcmp(pos, delim, delim_len) == 0)
+            return pos;
+    }
+
+    return NULL;
+}
+
+#ifdef UTILS_HAS_X86_SIMD
+
+// every set bit of a block mask is a position where both the first and the last byte of the
+// delimiter match, only those candidates are compared in full
+static const char *find_delim_candidates(const char *block, u64 mask, const char *delim,
+                                         usize delim_len)
+{
+    while (mask) {
+        const char *candidate = block + __builtin_ctzll(mask);
+
+        if (delim_len <= 2 || memcmp(candidate + 1, delim + 1, delim_len - 2) == 0)
+            return candidate;
+
+        mask &= mask - 1;
+    }
+
+    return NULL;
+}
+
+static const char *find_delim_sse2(const char *data, usize len, const char *delim,
+                                   usize delim_len)
+{
+    const __m128i first = _mm_set1_epi8(delim[0]);
+    const __m128i last = _mm_set1_epi8(delim[delim_len - 1]);
+    usize i = 0;
+
+    for (; i + 64 + delim_len - 1 <= len; i += 64) {
+        u64 mask = 0;
+
+        for (usize lane = 0; lane < 4; ++lane) {
+            const char *pos = data + i + lane * 16;
+            __m128i head = _mm_loadu_si128((const __m128i *)pos);
+            __m128i tail = _mm_loadu_si128((const __m128i *)(pos + delim_len - 1));
+            __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last));
+
+            mask |= (u64)(u16)_mm_movemask_epi8(eq) << (lane * 16);
+        }
+
+        const char *found = find_delim_candidates(data + i, mask, delim, delim_len);
+        if (found)
+            return found;
+    }
+
+    return find_delim_scalar(data + i, len - i, delim, delim_len);
+}
+
+__attribute__((target("avx2"))) static const char *
+find_delim_avx2(const char *data, usize len, const char *delim, usize delim_len)
+{
+    const __m256i first = _mm256_set1_epi8(delim[0]);
+    const __m256i last = _mm256_set1_epi8(delim[delim_len - 1]);
+    usize i = 0;
+
+    for (; i + 64 + delim_len - 1 <= len; i += 64) {
+        u64 mask = 0;
+
+        for (usize lane = 0; lane < 2; ++lane) {
+            const char *pos = data + i + lane * 32;
+            __m256i head = _mm256_loadu_si256((const __m256i *)pos);
+            __m256i tail = _mm256_loadu_si256((const __m256i *)(pos + delim_len - 1));
+            __m256i eq =
+                _mm256_and_si256(_mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, last));
+
+            mask |= (u64)(u32)_mm256_movemask_epi8(eq) << (lane * 32);
+        }
+
+        const char *found = find_delim_candidates(data + i, mask, delim, delim_len);
+        if (found)
+            return found;
+    }
+
+    return find_delim_scalar(data + i, len - i, delim, delim_len);
+}
+
+#endif // UTILS_HAS_X86_SIMD
+
+typedef const char *(*find_delim_fn)(const char *, usize, const char *, usize);
+
+static find_delim_fn find_delim_select(void)
+{
+#ifdef UTILS_HAS_X86_SIMD
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+        return find_delim_avx2;
+
+    return find_delim_sse2;
+#else
+    return find_delim_scalar;
+#endif
+}
+
+const char *find_delim(const char *data, usize len, const char *delim, usize delim_len)
+{
+    // selecting is idempotent, threads racing on the first call just pick the same function
+    static _Atomic(find_delim_fn) cached = NULL;
+
+    if (delim_len == 0 || delim_len > len)
+        return NULL;
+
+    find_delim_fn impl = atomic_load_explicit(&cached, memory_order_relaxed);
+
+    if (!impl) {
+        impl = find_delim_select();
+        atomic_store_explicit(&cached, impl, memory_order_relaxed);
+    }
+
+    return impl(data, len, delim, delim_len);
+}
 
 string_chunks_t *split_str(arena_t *arena, const char *input, const char *delim)
 {
@@ -39,6 +199,7 @@ string_chunks_t *split_str(arena_t *arena, const char *input, const char *delim)
     arena_da_init(arena, chunks, ARENA_DA_CAPACITY);
 
     const char *current_pos = input;
+    const char *input_end = input + strlen(input);
     const char *next_delim = NULL;
     size_t delim_len = strlen(delim);
 
@@ -46,7 +207,8 @@ string_chunks_t *split_str(arena_t *arena, const char *input, const char *delim)
         return chunks;
     }
 
-    while ((next_delim = strstr(current_pos, delim)) != NULL) {
+    while ((next_delim = find_delim(current_pos, (usize)(input_end - current_pos), delim,
+                                    delim_len)) != NULL) {
         assert(next_delim >= current_pos);
 
         isize len = next_delim - current_pos;
@@ -62,7 +224,7 @@ string_chunks_t *split_str(arena_t *arena, const char *input, const char *delim)
         current_pos = next_delim + delim_len;
     }
 
-    size_t last_len = strlen(current_pos);
+    size_t last_len = (usize)(input_end - current_pos);
 
     if (last_len > 0) {
         char *token = arena_alloc(arena, last_len + 1);
@@ -77,18 +239,387 @@ string_chunks_t *split_str(arena_t *arena, const char *input, const char *delim)
     return chunks;
 }
 
-i64 parse_int(const char *source, int base)
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define UTILS_HAS_SWAR 1
+#endif
+
+#ifdef UTILS_HAS_SWAR
+
+static u64 swar_load(const char *source)
+{
+    u64 chunk = 0;
+    memcpy(&chunk, source, sizeof(chunk));
+    return chunk;
+}
+
+static bool swar_is_decimal(u64 chunk)
+{
+    return ((chunk & 0xF0F0F0F0F0F0F0F0) |
+            (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333;
+}
+
+// folds eight ASCII digits pairwise into 2, 4 and finally 8 digit numbers
+static u64 swar_parse_decimal(u64 chunk)
+{
+    chunk -= 0x3030303030303030;
+    chunk = (chunk * 10) + (chunk >> 8);
+    chunk = (((chunk & 0x000000FF000000FF) * (100 + (1000000ULL << 32))) +
+             (((chunk >> 16) & 0x000000FF000000FF) * (1 + (10000ULL << 32)))) >>
+            32;
+    return chunk & 0xFFFFFFFF;
+}
+
+static bool swar_is_binary(u64 chunk)
+{
+    return (chunk & 0xFEFEFEFEFEFEFEFE) == 0x3030303030303030;
+}
+
+// moves the low bit of byte k to bit 7 - k of the top byte, first character most significant
+static u64 swar_parse_binary(u64 chunk)
+{
+    return ((chunk & 0x0101010101010101) * 0x8040201008040201) >> 56;
+}
+
+#endif // UTILS_HAS_SWAR
+
+static u64 parse_digit(char c)
 {
-    errno = 0;
-    char *end = { 0 };
-    i64 value = strtoll(source, &end, base);
+    if (c >= '0' && c <= '9')
+        return (u64)(c - '0');
+    if (c >= 'a' && c <= 'z')
+        return (u64)(c - 'a' + 10);
+    if (c >= 'A' && c <= 'Z')
+        return (u64)(c - 'A' + 10);
+    return UINT64_MAX;
+}
+
+// parses the leading digits of source, the caller decides what trailing bytes mean
+usize parse_u64(const char *source, usize len, int base, u64 *value, parse_err_t *error)
+{
+    assert(base >= 2 && base <= 36);
+
+    u64 result = 0;
+    usize i = 0;
+    *error = PARSE_OK;
 
-    if (*end != '\0' || errno == EINVAL || errno == ERANGE) {
-        fprintf(stderr, "Failed to convert \"%s\" to i64\n", source);
-        exit(EXIT_FAILURE);
+#ifdef UTILS_HAS_SWAR
+    if (base == 10) {
+        for (; i + 8 <= len && swar_is_decimal(swar_load(source + i)); i += 8) {
+            u64 digits = swar_parse_decimal(swar_load(source + i));
+
+            if (result > (UINT64_MAX - digits) / 100000000) {
+                *error = PARSE_OVERFLOW;
+                return i;
+            }
+
+            result = result * 100000000 + digits;
+        }
+    } else if (base == 2) {
+        for (; i + 8 <= len && swar_is_binary(swar_load(source + i)); i += 8) {
+            if (result >> 56) {
+                *error = PARSE_OVERFLOW;
+                return i;
+            }
+
+            result = (result << 8) | swar_parse_binary(swar_load(source + i));
+        }
+    }
+#endif
+
+    for (; i < len; ++i) {
+        u64 digit = parse_digit(source[i]);
+        if (digit >= (u64)base)
+            break;
+
+        if (result > (UINT64_MAX - digit) / (u64)base) {
+            *error = PARSE_OVERFLOW;
+            return i;
+        }
+
+        result = result * (u64)base + digit;
+    }
+
+    if (i == 0)
+        *error = PARSE_EMPTY;
+
+    *value = result;
+    return i;
+}
+
+usize parse_i64(const char *source, usize len, int base, i64 *value, parse_err_t *error)
+{
+    usize sign_len = len > 0 && (source[0] == '-' || source[0] == '+');
+    bool negative = sign_len && source[0] == '-';
+    u64 magnitude = 0;
+
+    usize consumed = parse_u64(source + sign_len, len - sign_len, base, &magnitude, error);
+    if (*error != PARSE_OK)
+        return sign_len + consumed;
+
+    if (magnitude > (negative ? (u64)INT64_MAX + 1 : (u64)INT64_MAX)) {
+        *error = PARSE_OVERFLOW;
+        return sign_len + consumed;
+    }
+
+    *value = negative ? (i64)(0 - magnitude) : (i64)magnitude;
+    return sign_len + consumed;
+}
+
+usize count_char(const char *data, usize len, char c)
+{
+    usize count = 0;
+    const char *end = data + len;
+
+    while ((data = memchr(data, c, (usize)(end - data))) != NULL) {
+        count += 1;
+        data += 1;
+    }
+
+    return count;
+}
+
+static bool is_list_blank(char c, char sep)
+{
+    return c != sep && isspace((unsigned char)c);
+}
+
+// reads the number at *pos and the separator after it, blanks around the number are skipped
+// and a trailing empty field ends the list
+static bool parse_list_next(const char *source, usize len, char sep, usize *pos, bool is_signed,
+                            u64 *value, parse_err_t *error)
+{
+    usize i = *pos;
+    *error = PARSE_OK;
+
+    while (i < len && is_list_blank(source[i], sep))
+        i++;
+
+    if (i == len)
+        return false;
+
+    if (is_signed) {
+        i64 signed_value = 0;
+        i += parse_i64(source + i, len - i, 10, &signed_value, error);
+        *value = (u64)signed_value;
+    } else {
+        i += parse_u64(source + i, len - i, 10, value, error);
+    }
+
+    if (*error != PARSE_OK)
+        return false;
+
+    while (i < len && is_list_blank(source[i], sep))
+        i++;
+
+    if (i < len && source[i] != sep) {
+        *error = PARSE_EMPTY;
+        return false;
+    }
+
+    *pos = i < len ? i + 1 : len;
+    return true;
+}
+
+u32 *parse_u32_list(arena_t *a, const char *source, usize len, char sep, usize *count)
+{
+    u32 *items = arena_alloc(a, (count_char(source, len, sep) + 1) * sizeof(*items));
+    if (!items)
+        return NULL;
+
+    usize size = 0;
+    usize pos = 0;
+    u64 value = 0;
+    parse_err_t error = PARSE_OK;
+
+    while (parse_list_next(source, len, sep, &pos, false, &value, &error)) {
+        if (value > UINT32_MAX)
+            return NULL;
+
+        items[size++] = (u32)value;
     }
 
-    return value;
+    if (error != PARSE_OK)
+        return NULL;
+
+    *count = size;
+    return items;
+}
+
+u64 *parse_u64_list(arena_t *a, const char *source, usize len, char sep, usize *count)
+{
+    u64 *items = arena_alloc(a, (count_char(source, len, sep) + 1) * sizeof(*items));
+    if (!items)
+        return NULL;
+
+    usize size = 0;
+    usize pos = 0;
+    parse_err_t error = PARSE_OK;
+
+    while (parse_list_next(source, len, sep, &pos, false, &items[size], &error))
+        size++;
+
+    if (error != PARSE_OK)
+        return NULL;
+
+    *count = size;
+    return items;
+}
+
+i64 *parse_i64_list(arena_t *a, const char *source, usize len, char sep, usize *count)
+{
+    i64 *items = arena_alloc(a, (count_char(source, len, sep) + 1) * sizeof(*items));
+    if (!items)
+        return NULL;
+
+    usize size = 0;
+    usize pos = 0;
+    u64 value = 0;
+    parse_err_t error = PARSE_OK;
+
+    while (parse_list_next(source, len, sep, &pos, true, &value, &error))
+        items[size++] = (i64)value;
+
+    if (error != PARSE_OK)
+        return NULL;
+
+    *count = size;
+    return items;
+}
+
+// LSD radix sort over bytes, passes where every key shares the same byte are skipped and the
+// ping-pong buffer only lives for the duration of the call
+#define RADIX_SORT_IMPL(type, a, items, count)                                              \
+    do {                                                                                    \
+        if ((count) < 2)                                                                    \
+            return true;                                                                    \
+                                                                                            \
+        arena_scratch_t scratch = arena_scratch_begin(a);                                   \
+        type *buffer = arena_alloc((a), (count) * sizeof(type));                            \
+        if (!buffer)                                                                        \
+            return false;                                                                   \
+                                                                                            \
+        type *src = (items);                                                                \
+        type *dst = buffer;                                                                 \
+                                                                                            \
+        for (usize shift = 0; shift < sizeof(type) * 8; shift += 8) {                       \
+            usize offsets[256] = { 0 };                                                     \
+                                                                                            \
+            for (usize i = 0; i < (count); ++i)                                             \
+                offsets[(src[i] >> shift) & 0xFF] += 1;                                     \
+                                                                                            \
+            if (offsets[(src[0] >> shift) & 0xFF] == (count))                               \
+                continue;                                                                   \
+                                                                                            \
+            usize total = 0;                                                                \
+            for (usize digit = 0; digit < 256; ++digit) {                                   \
+                usize digit_count = offsets[digit];                                         \
+                offsets[digit] = total;                                                     \
+                total += digit_count;                                                       \
+            }                                                                               \
+                                                                                            \
+            for (usize i = 0; i < (count); ++i)                                             \
+                dst[offsets[(src[i] >> shift) & 0xFF]++] = src[i];                          \
+                                                                                            \
+            type *tmp = src;                                                                \
+            src = dst;                                                                      \
+            dst = tmp;                                                                      \
+        }                                                                                   \
+                                                                                            \
+        if (src != (items))                                                                 \
+            memcpy((items), src, (count) * sizeof(type));                                   \
+                                                                                            \
+        arena_scratch_end(scratch);                                                         \
+        return true;                                                                        \
+    } while (0)
+
+bool radix_sort_u32(arena_t *a, u32 *items, usize count)
+{
+    RADIX_SORT_IMPL(u32, a, items, count);
+}
+
+bool radix_sort_u64(arena_t *a, u64 *items, usize count)
+{
+    RADIX_SORT_IMPL(u64, a, items, count);
+}
+
+// introselect: quickselect on a median of three pivot, once the depth budget runs out the
+// pivot comes from median of medians so the worst case stays linear
+#define SELECT_NTH_IMPL(type, items, count, nth)                                              \
+    do {                                                                                      \
+        assert((nth) < (count));                                                              \
+                                                                                              \
+        usize lo = 0;                                                                         \
+        usize hi = (count);                                                                   \
+        usize depth_budget = 0;                                                               \
+        for (usize n = (count); n > 1; n >>= 1)                                               \
+            depth_budget += 2;                                                                \
+                                                                                              \
+        while (hi - lo > 1) {                                                                 \
+            type pivot = 0;                                                                   \
+            usize len = hi - lo;                                                              \
+                                                                                              \
+            if (depth_budget > 0) {                                                           \
+                depth_budget -= 1;                                                            \
+                type x = (items)[lo];                                                         \
+                type y = (items)[lo + len / 2];                                               \
+                type z = (items)[hi - 1];                                                     \
+                pivot = MAX(MIN(x, y), MIN(MAX(x, y), z));                                    \
+            } else {                                                                          \
+                /* gather the median of every group of five at the front, recurse on them */  \
+                usize medians = 0;                                                            \
+                for (usize group = lo; group < hi; group += 5) {                              \
+                    usize group_end = MIN(group + 5, hi);                                     \
+                    for (usize i = group + 1; i < group_end; ++i) {                           \
+                        for (usize j = i; j > group && (items)[j - 1] > (items)[j]; --j) {    \
+                            type tmp = (items)[j];                                            \
+                            (items)[j] = (items)[j - 1];                                      \
+                            (items)[j - 1] = tmp;                                             \
+                        }                                                                     \
+                    }                                                                         \
+                    type median = (items)[group + (group_end - group) / 2];                   \
+                    (items)[group + (group_end - group) / 2] = (items)[lo + medians];         \
+                    (items)[lo + medians] = median;                                           \
+                    medians += 1;                                                             \
+                }                                                                             \
+                pivot = select_nth_##type((items) + lo, medians, medians / 2);                \
+            }                                                                                 \
+                                                                                              \
+            /* three-way partition: [lo, lt) < pivot, [lt, gt) == pivot, [gt, hi) > pivot */  \
+            usize lt = lo;                                                                    \
+            usize gt = hi;                                                                    \
+            usize i = lo;                                                                     \
+            while (i < gt) {                                                                  \
+                type value = (items)[i];                                                      \
+                if (value < pivot) {                                                          \
+                    (items)[i++] = (items)[lt];                                               \
+                    (items)[lt++] = value;                                                    \
+                } else if (value > pivot) {                                                   \
+                    (items)[i] = (items)[--gt];                                               \
+                    (items)[gt] = value;                                                      \
+                } else {                                                                      \
+                    i++;                                                                      \
+                }                                                                             \
+            }                                                                                 \
+                                                                                              \
+            if ((nth) < lt)                                                                   \
+                hi = lt;                                                                      \
+            else if ((nth) >= gt)                                                             \
+                lo = gt;                                                                      \
+            else                                                                              \
+                return pivot;                                                                 \
+        }                                                                                     \
+                                                                                              \
+        return (items)[(nth)];                                                                \
+    } while (0)
+
+u32 select_nth_u32(u32 *items, usize count, usize nth)
+{
+    SELECT_NTH_IMPL(u32, items, count, nth);
+}
+
+u64 select_nth_u64(u64 *items, usize count, usize nth)
+{
+    SELECT_NTH_IMPL(u64, items, count, nth);
 }
 
 char *trim_left(char *str)
@@ -0,0 +1,463 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#define ARENA_IMPLEMENTATION
+#define PERF_IMPLEMENTATION
+#define TIMER_IMPLEMENTATION
+#define FILE_IMPLEMENTATION
+#define UTILS_IMPLEMENTATION
+#define STR_IMPLEMENTATION
+#define POOL_IMPLEMENTATION
+#define HASHMAP_IMPLEMENTATION
+#define THREAD_POOL_IMPLEMENTATION
+#define PARALLEL_SPLIT_IMPLEMENTATION
+#define CACHE_IMPLEMENTATION
+#define LOGGER_IMPLEMENTATION
+#define DAY_IMPLEMENTATION
+
+#include "arena.h"
+#include "perf.h"
+#include "timer.h"
+#include "file.h"
+#include "utils.h"
+#include "str.h"
+#include "pool.h"
+#include "hashmap.h"
+#include "thread_pool.h"
+#include "parallel_split.h"
+#include "cache.h"
+#include "logger.h"
+#include "day.h"
+
+#define RUNNER_ARENA_SIZE (64 * 1024)
+#define RUNNER_PHASE_TOTAL DAY_PHASE_COUNT
+#define RUNNER_PHASES (DAY_PHASE_COUNT + 1)
+
+extern const day_t day001;
+extern const day_t day002;
+extern const day_t day003;
+extern const day_t day004;
+extern const day_t day005;
+extern const day_t day006;
+extern const day_t day007;
+
+static const day_t *const days[] = {
+    &day001, &day002, &day003, &day004, &day005, &day006, &day007,
+};
+
+#define DAYS_LEN (sizeof(days) / sizeof(*days))
+
+typedef struct {
+    const char *day; // a day name or "all"
+    const char *input;
+    usize iterations;
+    bool json;
+    bool sequential;
+} runner_options_t;
+
+typedef struct {
+    u64 median;
+    u64 p90;
+    u64 p99;
+} runner_summary_t;
+
+typedef struct {
+    const day_t *day;
+    const char *input;
+    bool solved;
+    i64 part1;
+    i64 part2;
+    u64 wall_ns; // every iteration of the day, setup included
+    runner_summary_t phases[RUNNER_PHASES];
+} runner_report_t;
+
+typedef struct {
+    const day_t *day;
+    const char *input;
+    usize iterations;
+    runner_report_t *report;
+} runner_job_t;
+
+static void print_usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [-n iterations] [--json] [--sequential] <dayXXX|all> [input|-]\n",
+            program);
+}
+
+static bool parse_options(int argc, char **argv, runner_options_t *options)
+{
+    *options = (runner_options_t){ .iterations = 1 };
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+
+        if (strcmp(arg, "--json") == 0) {
+            options->json = true;
+        } else if (strcmp(arg, "--sequential") == 0) {
+            options->sequential = true;
+        } else if (strcmp(arg, "-n") == 0 && i + 1 < argc) {
+            const char *count = argv[++i];
+            usize len = strlen(count);
+            u64 value = 0;
+            parse_err_t error = PARSE_OK;
+
+            if (parse_u64(count, len, 10, &value, &error) != len || error != PARSE_OK ||
+                value == 0)
+                return false;
+
+            options->iterations = (usize)value;
+        } else if (!options->day) {
+            options->day = arg;
+        } else if (!options->input) {
+            options->input = arg;
+        } else {
+            return false;
+        }
+    }
+
+    return options->day != NULL;
+}
+
+static const day_t *find_day(const char *name)
+{
+    for (usize i = 0; i < DAYS_LEN; ++i) {
+        if (strcmp(days[i]->name, name) == 0)
+            return days[i];
+    }
+
+    return NULL;
+}
+
+// nearest rank, samples are sorted in place
+static runner_summary_t summarize(arena_t *arena, u64 *samples, usize count)
+{
+    runner_summary_t summary = { 0 };
+
+    if (count == 0 || !radix_sort_u64(arena, samples, count))
+        return summary;
+
+    u32 percents[] = { 50, 90, 99 };
+    u64 *targets[] = { &summary.median, &summary.p90, &summary.p99 };
+
+    for (usize i = 0; i < sizeof(percents) / sizeof(*percents); ++i) {
+        usize rank = (count * percents[i] + 99) / 100;
+        *targets[i] = samples[rank > 0 ? rank - 1 : 0];
+    }
+
+    return summary;
+}
+
+// runs one day for every iteration on a reused arena, stdin can only be consumed once so it is
+// read up front and only that single read is reported
+static bool bench_day(const day_t *day, const char *input, usize iterations, arena_t *arena,
+                      runner_report_t *report)
+{
+    *report = (runner_report_t){ .day = day, .input = input };
+
+    u64 *samples[RUNNER_PHASES] = { 0 };
+    usize counts[RUNNER_PHASES] = { 0 };
+
+    for (usize phase = 0; phase < RUNNER_PHASES; ++phase) {
+        samples[phase] = arena_alloc(arena, iterations * sizeof(*samples[phase]));
+        if (!samples[phase])
+            return false;
+    }
+
+    str_t source = { 0 };
+    bool from_stdin = strcmp(input, "-") == 0;
+    u64 stdin_read_ns = 0;
+
+    if (from_stdin) {
+        usize size = 0;
+        u64 start = day_now_ns();
+        char *data = get_input_fd(arena, STDIN_FILENO, &size);
+        stdin_read_ns = day_now_ns() - start;
+
+        if (!data) {
+            LOG(LOG_ERROR, "%s: failed to read standard input", day->name);
+            return false;
+        }
+
+        source = (str_t){ .data = data, .len = size };
+        samples[DAY_PHASE_READ][counts[DAY_PHASE_READ]++] = stdin_read_ns;
+    }
+
+    u64 input_bytes = source.len;
+
+    if (!from_stdin)
+        input_size(input, &input_bytes);
+
+    arena_t run_arena = { 0 };
+    if (!day_arena_create(&run_arena, input_bytes, RUNNER_ARENA_SIZE))
+        return false;
+
+    for (usize i = 0; i < iterations; ++i) {
+        day_result_t result = { 0 };
+
+        arena_clean(&run_arena);
+
+        bool solved = from_stdin ? day_solve(day, &run_arena, source, &result)
+                                 : day_run(day, &run_arena, input, &result);
+        if (!solved)
+            goto done;
+
+        if (i > 0 && (result.part1 != report->part1 || result.part2 != report->part2)) {
+            LOG(LOG_ERROR, "%s: iteration %zu disagrees with the first one", day->name, i);
+            goto done;
+        }
+
+        report->part1 = result.part1;
+        report->part2 = result.part2;
+
+        u64 total = from_stdin ? stdin_read_ns : 0;
+
+        for (usize phase = 0; phase < DAY_PHASE_COUNT; ++phase) {
+            total += result.phase_ns[phase];
+
+            if (phase == DAY_PHASE_READ && from_stdin)
+                continue;
+
+            samples[phase][counts[phase]++] = result.phase_ns[phase];
+        }
+
+        samples[RUNNER_PHASE_TOTAL][counts[RUNNER_PHASE_TOTAL]++] = total;
+    }
+
+    report->solved = true;
+
+    for (usize phase = 0; phase < RUNNER_PHASES; ++phase)
+        report->phases[phase] = summarize(arena, samples[phase], counts[phase]);
+
+done:
+    arena_destroy(&run_arena);
+    return report->solved;
+}
+
+// high water mark of the whole process, so it only describes a day when run on its own
+static u64 peak_rss_kib(void)
+{
+    struct rusage usage = { 0 };
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+#ifdef __APPLE__
+    return (u64)usage.ru_maxrss / 1024;
+#else
+    return (u64)usage.ru_maxrss;
+#endif
+}
+
+// every day gets its own arenas, so days share nothing but the logger, the timers and the
+// default thread pool, which are all safe to use from several threads
+static void *run_job(void *arg)
+{
+    runner_job_t *job = arg;
+    arena_t arena = { 0 };
+
+    *job->report = (runner_report_t){ .day = job->day, .input = job->input };
+
+    u64 start = day_now_ns();
+
+    if (arena_create(&arena, RUNNER_ARENA_SIZE)) {
+        bench_day(job->day, job->input, job->iterations, &arena, job->report);
+        arena_destroy(&arena);
+    }
+
+    job->report->wall_ns = day_now_ns() - start;
+    return NULL;
+}
+
+static const char *phase_name(usize phase)
+{
+    return phase == RUNNER_PHASE_TOTAL ? "total" : day_phase_name((day_phase_t)phase);
+}
+
+static u64 sum_wall_ns(const runner_report_t *reports, usize count)
+{
+    u64 sum = 0;
+
+    for (usize i = 0; i < count; ++i)
+        sum += reports[i].wall_ns;
+
+    return sum;
+}
+
+static void print_text(const runner_report_t *reports, usize count, usize iterations,
+                       u64 wall_ns)
+{
+    for (usize i = 0; i < count; ++i) {
+        const runner_report_t *report = &reports[i];
+
+        printf("%s (%s, %zu iterations, %.3f ms)\n", report->day->name, report->input,
+               iterations, (double)report->wall_ns / 1e6);
+
+        if (!report->solved) {
+            printf("  failed\n");
+            continue;
+        }
+
+        printf("  part 1: %lld\n", (long long)report->part1);
+        printf("  part 2: %lld\n", (long long)report->part2);
+        printf("  %-8s %14s %14s %14s\n", "phase", "median us", "p90 us", "p99 us");
+
+        for (usize phase = 0; phase < RUNNER_PHASES; ++phase) {
+            const runner_summary_t *summary = &report->phases[phase];
+
+            printf("  %-8s %14.3f %14.3f %14.3f\n", phase_name(phase),
+                   (double)summary->median / 1000.0, (double)summary->p90 / 1000.0,
+                   (double)summary->p99 / 1000.0);
+        }
+    }
+
+    if (count > 1) {
+        u64 sum = sum_wall_ns(reports, count);
+
+        printf("wall %.3f ms, sum of days %.3f ms (%.2fx)\n", (double)wall_ns / 1e6,
+               (double)sum / 1e6, wall_ns ? (double)sum / (double)wall_ns : 0.0);
+    }
+
+    printf("peak rss: %llu KiB\n", (unsigned long long)peak_rss_kib());
+}
+
+static void print_json_string(const char *str)
+{
+    putchar('"');
+
+    for (const unsigned char *c = (const unsigned char *)str; *c; ++c) {
+        if (*c == '"' || *c == '\\')
+            printf("\\%c", *c);
+        else if (*c < 0x20)
+            printf("\\u%04x", *c);
+        else
+            putchar(*c);
+    }
+
+    putchar('"');
+}
+
+static void print_json(const runner_report_t *reports, usize count, usize iterations,
+                       u64 wall_ns)
+{
+    printf("{\"iterations\":%zu,\"days\":[", iterations);
+
+    for (usize i = 0; i < count; ++i) {
+        const runner_report_t *report = &reports[i];
+
+        printf("%s{\"day\":", i > 0 ? "," : "");
+        print_json_string(report->day->name);
+        printf(",\"input\":");
+        print_json_string(report->input);
+        printf(",\"solved\":%s,\"wall_ns\":%llu", report->solved ? "true" : "false",
+               (unsigned long long)report->wall_ns);
+
+        if (report->solved) {
+            printf(",\"part1\":%lld,\"part2\":%lld,\"phases\":{", (long long)report->part1,
+                   (long long)report->part2);
+
+            for (usize phase = 0; phase < RUNNER_PHASES; ++phase) {
+                const runner_summary_t *summary = &report->phases[phase];
+
+                printf("%s\"%s\":{\"median_ns\":%llu,\"p90_ns\":%llu,\"p99_ns\":%llu}",
+                       phase > 0 ? "," : "", phase_name(phase),
+                       (unsigned long long)summary->median, (unsigned long long)summary->p90,
+                       (unsigned long long)summary->p99);
+            }
+
+            printf("}");
+        }
+
+        printf("}");
+    }
+
+    printf("],\"wall_ns\":%llu,\"days_wall_ns\":%llu,\"peak_rss_kib\":%llu}\n",
+           (unsigned long long)wall_ns, (unsigned long long)sum_wall_ns(reports, count),
+           (unsigned long long)peak_rss_kib());
+}
+
+int main(int argc, char **argv)
+{
+    runner_options_t options = { 0 };
+
+    if (!parse_options(argc, argv, &options)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    bool all = strcmp(options.day, "all") == 0;
+    const day_t *selected = all ? NULL : find_day(options.day);
+
+    if (!all && !selected) {
+        LOG(LOG_ERROR, "Unknown day '%s'", options.day);
+        return 1;
+    }
+
+    if (all && options.input) {
+        LOG(LOG_ERROR, "%s", "An input can only be given for a single day");
+        return 1;
+    }
+
+    arena_t arena = { 0 };
+
+    if (!arena_create(&arena, RUNNER_ARENA_SIZE)) {
+        LOG(LOG_ERROR, "%s", "Failed to create arena");
+        return 1;
+    }
+
+    usize count = all ? DAYS_LEN : 1;
+    runner_report_t *reports = arena_alloc(&arena, count * sizeof(*reports));
+    runner_job_t *jobs = arena_alloc(&arena, count * sizeof(*jobs));
+    pthread_t *threads = arena_alloc(&arena, count * sizeof(*threads));
+    bool *started = arena_alloc(&arena, count * sizeof(*started));
+
+    if (!reports || !jobs || !threads || !started) {
+        LOG(LOG_ERROR, "%s", "Out of memory");
+        arena_destroy(&arena);
+        return 1;
+    }
+
+    u64 start = day_now_ns();
+
+    // days run on their own threads and only report once all of them are done, so the output
+    // stays in day order. A day whose thread cannot be started runs on this one
+    for (usize i = 0; i < count; ++i) {
+        const day_t *day = all ? days[i] : selected;
+
+        jobs[i] = (runner_job_t){
+            .day = day,
+            .input = options.input ? options.input : day->input,
+            .iterations = options.iterations,
+            .report = &reports[i],
+        };
+
+        started[i] = count > 1 && !options.sequential &&
+                     pthread_create(&threads[i], NULL, run_job, &jobs[i]) == 0;
+
+        if (!started[i])
+            run_job(&jobs[i]);
+    }
+
+    bool solved = true;
+
+    for (usize i = 0; i < count; ++i) {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+
+        solved = solved && reports[i].solved;
+    }
+
+    u64 wall_ns = day_now_ns() - start;
+
+    if (options.json)
+        print_json(reports, count, options.iterations, wall_ns);
+    else
+        print_text(reports, count, options.iterations, wall_ns);
+
+    arena_destroy(&arena);
+
+    return solved ? 0 : 1;
+}